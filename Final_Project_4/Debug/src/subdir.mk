@@ -4,21 +4,96 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../src/adc.c \
+../src/chart.c \
+../src/defer.c \
+../src/display.c \
+../src/evtrace.c \
+../src/fmt.c \
+../src/font.c \
+../src/idle.c \
 ../src/initialize-hardware.c \
+../src/irq.c \
+../src/latency.c \
 ../src/main.c \
+../src/meas.c \
+../src/memdiag.c \
+../src/metrics.c \
+../src/oled.c \
+../src/oled_fb.c \
+../src/oled_panel.c \
+../src/prof.c \
+../src/ring.c \
+../src/sched.c \
 ../src/stm32f0xx_hal_msp.c \
+../src/sweep.c \
+../src/swtimer.c \
+../src/text.c \
+../src/timer.c \
+../src/uart.c \
+../src/ui.c \
 ../src/write.c 
 
 C_DEPS += \
+./src/adc.d \
+./src/chart.d \
+./src/defer.d \
+./src/display.d \
+./src/evtrace.d \
+./src/fmt.d \
+./src/font.d \
+./src/idle.d \
 ./src/initialize-hardware.d \
+./src/irq.d \
+./src/latency.d \
 ./src/main.d \
+./src/meas.d \
+./src/memdiag.d \
+./src/metrics.d \
+./src/oled.d \
+./src/oled_fb.d \
+./src/oled_panel.d \
+./src/prof.d \
+./src/ring.d \
+./src/sched.d \
 ./src/stm32f0xx_hal_msp.d \
+./src/sweep.d \
+./src/swtimer.d \
+./src/text.d \
+./src/timer.d \
+./src/uart.d \
+./src/ui.d \
 ./src/write.d 
 
 OBJS += \
+./src/adc.o \
+./src/chart.o \
+./src/defer.o \
+./src/display.o \
+./src/evtrace.o \
+./src/fmt.o \
+./src/font.o \
+./src/idle.o \
 ./src/initialize-hardware.o \
+./src/irq.o \
+./src/latency.o \
 ./src/main.o \
+./src/meas.o \
+./src/memdiag.o \
+./src/metrics.o \
+./src/oled.o \
+./src/oled_fb.o \
+./src/oled_panel.o \
+./src/prof.o \
+./src/ring.o \
+./src/sched.o \
 ./src/stm32f0xx_hal_msp.o \
+./src/sweep.o \
+./src/swtimer.o \
+./src/text.o \
+./src/timer.o \
+./src/uart.o \
+./src/ui.o \
 ./src/write.o 
 
 
@@ -0,0 +1,29 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Interrupt-driven single conversions on ADC1 as a protothread.
+//
+// The channel, resolution and sampling time are set up by the caller
+// (myGPIOA_Init); this driver only starts a conversion and waits for
+// ADRDY / EOC through the ADC interrupt, which calls kick. The sweep
+// (sweep.c) takes the ADC over while it runs: a read in progress must then
+// be dropped with adc_Cancel(). A read starts only with ADSTART clear; the
+// sweep waits for ADSTP before it hands the ADC back.
+// ----------------------------------------------------------------------------
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#include <stdint.h>
+#include "pt.h"
+
+// kick runs in interrupt context when a waiting read can continue
+void adc_Init(void (*kick)(void));
+
+// One conversion of the selected channel into *out (12-bit, right aligned)
+PT_THREAD(adc_Read(pt_Thread *pt, uint16_t *out));
+
+// Abandon a read (the thread must be re-initialised before the next one)
+void adc_Cancel(void);
+
+#endif // ADC_H_
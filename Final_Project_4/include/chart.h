@@ -0,0 +1,73 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Trend chart widget drawn into the OLED framebuffer.
+//
+// Raw samples are decimated into min/max buckets, so a short glitch still
+// shows up as a spike after decimation. The buckets are kept in a ring
+// buffer supplied by the caller, one bucket per screen column. The vertical
+// axis follows the data: it grows as soon as a bucket falls outside it and
+// shrinks once the data uses less than a quarter of it.
+//
+// CHART_SCROLL keeps the newest bucket at the right edge, so the whole plot
+// moves on every new bucket. CHART_SWEEP writes the new bucket at a cursor
+// that wraps around, like a roll-mode scope, so only the new column and the
+// blank column after it change on the panel.
+// ----------------------------------------------------------------------------
+
+#ifndef CHART_H_
+#define CHART_H_
+
+#include <stdint.h>
+
+#define CHART_MAX_PAGES		4		// plot height up to 32 rows
+
+typedef enum {
+	CHART_SCROLL = 0, CHART_SWEEP
+} chart_Mode;
+
+typedef struct {
+	uint16_t lo;
+	uint16_t hi;
+} chart_Bucket;
+
+typedef struct {
+	chart_Bucket *ring;		// width buckets, owned by the caller
+	uint8_t width;			// columns (and buckets)
+	uint8_t page;			// top page of the plot
+	uint8_t col;			// left column of the plot
+	uint8_t pages;			// height in pages (1..CHART_MAX_PAGES)
+	uint8_t mode;			// chart_Mode
+	uint8_t decimation;		// raw samples per bucket
+	uint8_t head;			// next bucket to write
+	uint8_t count;			// valid buckets
+	uint8_t pending;		// buckets added since the last chart_Draw()
+	uint8_t redraw;			// whole plot must be redrawn
+	uint8_t acc_n;			// raw samples in acc
+	chart_Bucket acc;		// bucket being filled
+	uint16_t axis_lo;		// value at the bottom row
+	uint16_t axis_hi;		// value at the top row
+	uint32_t scale;			// rows per unit, Q16 (no divide per column)
+} chart_Chart;
+
+void chart_Init(chart_Chart *chart, chart_Bucket *ring, uint8_t width,
+		uint8_t page, uint8_t col, uint8_t pages, uint8_t decimation,
+		chart_Mode mode);
+
+// Forget the history and blank the plot area on the next chart_Draw()
+void chart_Clear(chart_Chart *chart);
+
+// Add one raw sample (saturated to 16 bits)
+void chart_Add(chart_Chart *chart, uint32_t value);
+
+// Draw the columns that changed since the last call (renderer context)
+void chart_Draw(chart_Chart *chart);
+
+// Redraw the whole plot on the next chart_Draw(), e.g. after the area was
+// used by something else
+void chart_Invalidate(chart_Chart *chart);
+
+// Current axis range, for labelling
+void chart_Axis(const chart_Chart *chart, uint16_t *lo, uint16_t *hi);
+
+#endif // CHART_H_
@@ -0,0 +1,47 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Deferred work: ISRs queue slow processing for the PendSV handler.
+//
+// An ISR captures its raw data, posts a work item (function + argument)
+// and returns; PendSV, at the lowest interrupt priority (irq.h), runs the
+// items after every other pending interrupt, ahead of the task loop. Each
+// posting ISR owns its own queue (a ring.h SPSC ring), so posting takes
+// no lock. Work items run with interrupts enabled: only the user button,
+// at the same level, waits behind them. The sweep (sweep.c) hands its
+// per-point DFT and frequency step over this way.
+// ----------------------------------------------------------------------------
+
+#ifndef DEFER_H_
+#define DEFER_H_
+
+#include <stdint.h>
+#include "ring.h"
+
+#define DEFER_MAX_QUEUES	4
+
+typedef void (*defer_Fn)(uint32_t arg);
+
+typedef struct {
+	defer_Fn fn;
+	uint32_t arg;
+} defer_Work;
+
+typedef struct {
+	ring_Ring ring;		// dropped = posts lost to a full queue
+	uint32_t max_depth;	// most items waiting at once
+} defer_Queue;
+
+// Static queue of depth items (a power of two) for one posting ISR
+#define DEFER_QUEUE(name, depth) \
+	static defer_Work name##_items[depth]; \
+	static defer_Queue name = { { (uint8_t *) name##_items, (depth) - 1, \
+			sizeof(defer_Work), 0, 0, 0 }, 0 }
+
+// Queues are drained in registration order; at most DEFER_MAX_QUEUES
+int defer_Register(defer_Queue *q);
+
+// From the ISR that owns q. Returns -1 if the queue is full.
+int defer_Post(defer_Queue *q, defer_Fn fn, uint32_t arg);
+
+#endif // DEFER_H_
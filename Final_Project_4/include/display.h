@@ -0,0 +1,74 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Non-blocking display refresh service.
+//
+// The application asks for a new frame with display_Request() whenever the
+// shown values change; at the next frame slot display_Service() runs the
+// renderer into the framebuffer and starts an asynchronous DMA flush.
+// Nothing here waits on the panel. The service is event-driven: requests,
+// wakes and a software timer for the next slot or power step call kick.
+// With nothing requested it only wakes for the next dim or off step, and
+// not at all once the panel is off.
+//
+// Power: with no display_Wake() for DISPLAY_DIM_MS the contrast is lowered,
+// and after DISPLAY_OFF_MS the panel is put to sleep (0xAE) and nothing is
+// rendered. display_Wake() restores it and the next frame is drawn at once
+// instead of at its slot; the time to that frame is kept in wake_ms.
+// ----------------------------------------------------------------------------
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+
+#define DISPLAY_DEFAULT_FPS	10
+
+#define DISPLAY_DIM_MS				30000	// idle time before dimming
+#define DISPLAY_OFF_MS				120000	// idle time before panel sleep
+#define DISPLAY_CONTRAST_ACTIVE		0xCF
+#define DISPLAY_CONTRAST_DIM		0x10
+
+typedef enum {
+	DISPLAY_ACTIVE = 0, DISPLAY_DIM, DISPLAY_OFF
+} display_Power;
+
+// Draws the current frame into the framebuffer (fb_* calls only)
+typedef void (*display_Renderer)(void);
+
+typedef struct {
+	uint32_t frames;	// flushes that sent at least one byte
+	uint32_t skipped;	// requested frames with nothing dirty (no bus traffic)
+	uint32_t dropped;	// frame slots lost because a flush was still running
+	uint16_t frame_ms;	// duration of the last flush, start to DMA done
+	uint16_t bytes;		// bytes sent by the last flush
+	uint16_t wake_ms;	// last wake from sleep to its first frame shown
+	uint16_t wake_max_ms;	// worst wake_ms (budget: 50 ms)
+} display_Stats;
+
+// kick (normally a sched_Post()) asks for display_Service() to run; it is
+// called from task context only. swtimer_Init() first.
+void display_Init(display_Renderer render, uint8_t fps, void (*kick)(void));
+
+// Target frame rate, 1..50 frames per second
+void display_SetFrameRate(uint8_t fps);
+
+// Mark the displayed values as changed; coalesced until the next slot
+void display_Request(void);
+
+// Idle times before dimming and sleep; 0 disables that step
+void display_SetIdleTimeouts(uint32_t dim_ms, uint32_t off_ms);
+
+// User or measurement activity: restart the idle time and undo dimming or
+// sleep. Returns nonzero if the panel was asleep, so a button press that
+// only woke the display can be ignored by the caller.
+uint8_t display_Wake(void);
+
+display_Power display_GetPower(void);
+
+// Run after each kick; never blocks
+void display_Service(void);
+
+const display_Stats* display_GetStats(void);
+
+#endif // DISPLAY_H_
@@ -0,0 +1,84 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Binary event trace for hot code (ISRs) in place of trace_printf().
+//
+// trace_printf() over semihosting halts the core for every call. An event
+// here is one fixed 12-byte record in a RAM ring: a microsecond timestamp,
+// an event id, a 24-bit and a 32-bit argument. Recording takes a slot
+// index with interrupts masked for three instructions, then three stores;
+// about 25 cycles in all, most of it the timestamp (timer_MicrosFast()).
+// Any context may record, at any priority. The oldest records are
+// overwritten.
+//
+// The target keeps no strings. tools/evtrace_decode.py holds the format
+// of every event id and turns a dump of evtrace_log into a timeline. Dump
+// it from the debugger:
+//   (gdb) dump binary value trace.bin evtrace_log
+// or over the console with the "trace" command. Event ids are append-only
+// so old dumps still decode; keep the two tables in step.
+// ----------------------------------------------------------------------------
+
+#ifndef EVTRACE_H_
+#define EVTRACE_H_
+
+#include <stdint.h>
+#include "cmsis/cmsis_device.h"
+#include "timer.h"
+
+#define EVTRACE_RECORDS	32			// power of two
+#define EVTRACE_MAGIC	0x31525645u	// "EVR1" little-endian
+
+typedef enum {
+	EVTRACE_NONE = 0,
+	EVTRACE_BUTTON,			// user button pressed
+	EVTRACE_OVERFLOW,		// TIM2 overflow, input too slow; a1 = TIM2 CNT
+	EVTRACE_TOO_FAST,		// period of 0 ticks
+	EVTRACE_CAPTURE,		// period captured; a0 = ring fill, a1 = ticks
+	EVTRACE_CAPTURE_DROP,	// capture ring full; a1 = ticks
+	EVTRACE_STOP,			// woke from Stop mode; a0 = ms slept
+	EVTRACE_SWEEP,			// sweep started (a0 = 1) or ended (a0 = 0)
+} evtrace_Id;
+
+typedef struct {
+	uint32_t time;			// timer_Micros() low 32 bits
+	uint32_t id_a0;			// [7:0] id, [31:8] a0
+	uint32_t a1;
+} evtrace_Record;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t records;		// EVTRACE_RECORDS
+	volatile uint32_t head;	// events recorded; head % records is next
+	volatile uint32_t paused;
+	evtrace_Record ring[EVTRACE_RECORDS];
+} evtrace_Log;
+
+extern evtrace_Log evtrace_log;
+
+static inline void evtrace_Event(evtrace_Id id, uint32_t a0, uint32_t a1) {
+	uint32_t time = timer_MicrosFast();
+	uint32_t primask = __get_PRIMASK();
+	uint32_t head;
+
+	if (evtrace_log.paused) {
+		return;
+	}
+	__disable_irq();
+	head = evtrace_log.head;
+	evtrace_log.head = head + 1;
+	__set_PRIMASK(primask);
+
+	evtrace_Record *r = &evtrace_log.ring[head & (EVTRACE_RECORDS - 1)];
+	r->time = time;
+	r->id_a0 = (uint32_t) id | (a0 << 8);
+	r->a1 = a1;
+}
+
+// Header for the decoder; before the first event
+void evtrace_Init(void);
+
+// Stop / restart recording, e.g. while the log is being sent
+void evtrace_Pause(uint8_t paused);
+
+#endif // EVTRACE_H_
@@ -0,0 +1,42 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Small number-to-text formatting for the display path.
+//
+// The Cortex-M0 has no divide instruction, so digits are extracted by
+// subtracting powers of ten (at most 9 compare/subtract steps per digit)
+// instead of going through snprintf and the libgcc division routines.
+// All functions write a '\0'-terminated string and return its length;
+// the caller's buffer must hold FMT_MAX_LEN bytes or width + 1, whichever
+// is larger.
+// ----------------------------------------------------------------------------
+
+#ifndef FMT_H_
+#define FMT_H_
+
+#include <stdint.h>
+
+#define FMT_MAX_LEN		13	// sign + 10 digits + '.' + '\0'
+
+// Decimal, right-aligned in width columns padded with pad (' ' or '0').
+// Values wider than width are written in full, as with printf.
+uint8_t fmt_Unsigned(char *buf, uint32_t value, uint8_t width, char pad);
+uint8_t fmt_Signed(char *buf, int32_t value, uint8_t width, char pad);
+
+// value / 10^decimals with a fixed number of decimals, e.g.
+// fmt_Fixed(buf, -1234, 3, 0) -> "-1.234" and (buf, 5, 2, 0) -> "0.05"
+uint8_t fmt_Fixed(char *buf, int32_t value, uint8_t decimals, uint8_t width);
+
+// value with an SI prefix chosen so 1-3 integer digits remain, rounded to
+// digits significant digits (at least the integer digits are kept). Only
+// the number is written; the prefix (' ', 'k', 'M' or 'G') is stored in
+// *prefix so the unit can be drawn separately. 12345 with 4 digits ->
+// "12.35" and 'k'; values below 1000 are written as plain integers.
+uint8_t fmt_SI(char *buf, uint32_t value, uint8_t digits, uint8_t width,
+		char *prefix);
+
+// Time the display formats against snprintf on the same values, into the
+// fmt and snprintf profiler zones (PROF_ENABLE only; empty otherwise)
+void fmt_Bench(void);
+
+#endif // FMT_H_
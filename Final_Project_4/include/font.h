@@ -0,0 +1,42 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Flash-resident fonts.
+//
+// Glyphs are stored column-wise (bit 0 = top row) for the printable range
+// only, indexed by c - first. The blank columns between characters are not
+// stored; the renderer adds font_Font.spacing after each glyph.
+// ----------------------------------------------------------------------------
+
+#ifndef FONT_H_
+#define FONT_H_
+
+#include <stdint.h>
+
+typedef struct {
+	const uint8_t *glyphs;	// count * width column bytes
+	uint8_t first;			// code of the first glyph
+	uint8_t count;			// number of glyphs
+	uint8_t width;			// columns per glyph
+	uint8_t spacing;		// blank columns added after each glyph
+} font_Font;
+
+// 5x7 ASCII font, 0x20-0x7F, 8-column cell
+extern const font_Font font_5x7;
+
+// Columns of c, or of '?' when c is outside the font
+const uint8_t* font_Glyph(const font_Font *font, unsigned char c);
+
+// 16x32 numeric font: digits, ' ', '-', '.', 'E' and 'r' ("Err")
+#define FONT_NUM_WIDTH		16		// columns per cell, gap included
+#define FONT_NUM_PAGES		4		// 32 rows
+
+// One 32-row column of c in the numeric font, bit 0 = top row
+uint32_t font_NumColumn(unsigned char c, uint8_t col);
+
+// Horizontal advance of one character cell
+static inline uint8_t font_Advance(const font_Font *font) {
+	return font->width + font->spacing;
+}
+
+#endif // FONT_H_
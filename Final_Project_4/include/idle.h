@@ -0,0 +1,43 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Low-power idle between scheduler tasks.
+//
+// With no task released the core either sleeps (WFI, all clocks running,
+// TIM3 compare as wakeup) or enters Stop mode (PLL, HSI and TIM3 off) when
+// the next release is at least IDLE_STOP_MIN_MS away and the application
+// allows it. Stop mode wakes on any EXTI line (button, frequency input) or
+// on an RTC alarm clocked from the LSI; the LSI is measured against the
+// 48 MHz clock at start-up so the time spent in Stop can be added back to
+// the millisecond timebase.
+// ----------------------------------------------------------------------------
+
+#ifndef IDLE_H_
+#define IDLE_H_
+
+#include <stdint.h>
+
+#define IDLE_STOP_MIN_MS	4		// shorter gaps are not worth the PLL relock
+
+typedef struct {
+	uint32_t sleeps;		// WFI entries
+	uint32_t stops;			// Stop mode entries
+	uint32_t stop_ms;		// time spent in Stop, from the RTC
+	uint32_t lsi_hz;		// measured LSI frequency
+} idle_Stats;
+
+// next_due: ms until work is due (0 = now), called with interrupts masked.
+// stop_ok: nonzero when no peripheral needs the system clock; may be 0 to
+// only ever use WFI.
+void idle_Init(uint16_t (*next_due)(void), uint8_t (*stop_ok)(void));
+
+// Scheduler idle hook: sleep until the next release or interrupt
+void idle_Enter(void);
+
+// Nonzero once after a Stop-mode wakeup. An edge that woke the core from
+// Stop was serviced a PLL relock late, so it must not start a measurement.
+uint8_t idle_TakeStopWake(void);
+
+const idle_Stats* idle_GetStats(void);
+
+#endif // IDLE_H_
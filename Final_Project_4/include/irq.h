@@ -0,0 +1,112 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Interrupt priority plan and optional latency/duration instrumentation.
+//
+// The M0 has four priority levels (0 = highest). Every IRQ gets its level
+// from its role in irq.c, applied by irq_Init() before any is enabled:
+//   IRQ_PRIO_CAPTURE   frequency edge (EXTI2_3) and TIM2 overflow; only
+//                      each other can delay a capture
+//   IRQ_PRIO_TIMEBASE  TIM3 wrap/compare and the RTC wakeup alarm
+//   IRQ_PRIO_IO        DMA completions (OLED SPI, sweep ADC), sweep TIM15,
+//                      pot ADC and the USART1 console
+//   IRQ_PRIO_UI        user button and the PendSV deferred work (defer.h)
+// Modules only enable their IRQs.
+//
+// Building with -DIRQ_INSTRUMENT adds per-IRQ measurements: duration from
+// the SysTick cycle counter (isrtime.h), and entry latency where the
+// interrupting timer shows how long ago the event was. Each result is
+// checked against the budget in the table; over-budget ISRs are counted
+// and printed by irq_Report(). Without the define the IRQ_* macros
+// compile to nothing.
+// ----------------------------------------------------------------------------
+
+#ifndef IRQ_H_
+#define IRQ_H_
+
+#include <stdint.h>
+#include "cmsis/cmsis_device.h"
+
+#define IRQ_PRIO_CAPTURE	0
+#define IRQ_PRIO_TIMEBASE	1
+#define IRQ_PRIO_IO			2
+#define IRQ_PRIO_UI			3
+
+typedef enum {
+	IRQ_ID_EXTI2_3 = 0,
+	IRQ_ID_TIM2,
+	IRQ_ID_TIM3,
+	IRQ_ID_RTC,
+	IRQ_ID_DMA_SPI,
+	IRQ_ID_DMA_ADC,
+	IRQ_ID_TIM15,
+	IRQ_ID_ADC,
+	IRQ_ID_USART1,
+	IRQ_ID_EXTI0_1,
+	IRQ_ID_PENDSV,
+	IRQ_COUNT
+} irq_Id;
+
+typedef struct {
+	const char *name;
+	IRQn_Type irq;
+	uint8_t priority;
+	uint16_t latency_budget;	// cycles, event to handler; 0 = not measured
+	uint16_t duration_budget;	// cycles, entry to exit; 0 = unchecked
+} irq_Config;
+
+// Set every NVIC priority from the plan
+void irq_Init(void);
+
+// Print measured maxima and budget violations (instrumentation build only)
+void irq_Report(void);
+
+#ifdef IRQ_INSTRUMENT
+
+#include "isrtime.h"
+
+typedef struct {
+	isrtime_Stat duration;
+	uint32_t latency_max;
+	uint32_t over;			// measurements above a budget
+} irq_Stats;
+
+extern const irq_Config irq_table[IRQ_COUNT];
+extern irq_Stats irq_stats[IRQ_COUNT];
+
+static inline void irq_Exit(irq_Id id, uint32_t start) {
+	irq_Stats *s = &irq_stats[id];
+
+	isrtime_Stop(&s->duration, start);
+	if (irq_table[id].duration_budget != 0
+			&& s->duration.last > irq_table[id].duration_budget) {
+		s->over++;
+	}
+}
+
+static inline void irq_Latency(irq_Id id, uint32_t cycles) {
+	irq_Stats *s = &irq_stats[id];
+
+	if (cycles > s->latency_max) {
+		s->latency_max = cycles;
+	}
+	if (cycles > irq_table[id].latency_budget) {
+		s->over++;
+	}
+}
+
+// First statement of a handler / just before it returns
+#define IRQ_ENTER()				uint32_t irq_start_ = isrtime_Start()
+#define IRQ_EXIT(id)			irq_Exit((id), irq_start_)
+// Cycles since the event that raised the interrupt
+#define IRQ_LATENCY(id, cycles)	irq_Latency((id), (cycles))
+
+#else
+
+#define IRQ_ENTER()				do { } while (0)
+#define IRQ_EXIT(id)			do { } while (0)
+#define IRQ_LATENCY(id, cycles)	do { } while (0)
+
+#endif // IRQ_INSTRUMENT
+
+#endif // IRQ_H_
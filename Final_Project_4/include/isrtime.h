@@ -0,0 +1,42 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// ISR duration measurement in core clock cycles.
+//
+// Reads the SysTick down-counter (free-running, prof.h) at entry and exit;
+// any reload period works as long as one ISR takes less than one SysTick
+// period. The two reads and the bookkeeping add about 20 cycles to each
+// measured ISR.
+// ----------------------------------------------------------------------------
+
+#ifndef ISRTIME_H_
+#define ISRTIME_H_
+
+#include <stdint.h>
+#include "cmsis/cmsis_device.h"
+
+typedef struct {
+	uint32_t count;
+	uint32_t last;		// cycles, entry to exit
+	uint32_t max;
+} isrtime_Stat;
+
+static inline uint32_t isrtime_Start(void) {
+	return SysTick->VAL;
+}
+
+static inline void isrtime_Stop(isrtime_Stat *s, uint32_t start) {
+	uint32_t end = SysTick->VAL;
+	uint32_t cycles = start - end;
+
+	if (end > start) {
+		cycles += SysTick->LOAD + 1;	// counter reloaded in between
+	}
+	s->count++;
+	s->last = cycles;
+	if (cycles > s->max) {
+		s->max = cycles;
+	}
+}
+
+#endif // ISRTIME_H_
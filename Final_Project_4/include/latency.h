@@ -0,0 +1,60 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Interrupt latency harness for the EXTI2 frequency input.
+//
+// Building with -DLATENCY_HARNESS measures how late EXTI2_3_IRQHandler
+// reads TIM2 after the input edge. Jumper the function generator input
+// PB2 to PB3. PB3 (AF2, TIM2_CH2) latches TIM2->CNT in CCR2 on the edge,
+// in hardware. The ISR reads TIM2->CNT first thing; the difference is the
+// entry latency in 48 MHz cycles. It is the error the EXTI-based period
+// measurement adds to each edge. Only edges that find TIM2 running are
+// measured (the ones that end a period), i.e. every other edge.
+//
+// Samples go into min/max/mean and a histogram of LATENCY_BUCKET_CYCLES
+// wide buckets, printed by latency_Report(). With IRQ_INSTRUMENT they are
+// also checked against the EXTI2_3 latency budget in irq.c. Without the
+// define LATENCY_SAMPLE() is empty and PB3 is left alone.
+// ----------------------------------------------------------------------------
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+#include "cmsis/cmsis_device.h"
+
+#define LATENCY_BUCKETS			32
+#define LATENCY_BUCKET_CYCLES	4	// the last bucket also counts longer
+
+// PB3 as TIM2_CH2 input capture; after myTIM2_Init()
+void latency_Init(void);
+
+// Print the latency statistics on the trace output
+void latency_Report(void);
+
+#ifdef LATENCY_HARNESS
+
+void latency_Record(uint32_t cycles);
+
+// First statement of EXTI2_3_IRQHandler, before TIM2 is touched
+static inline void latency_Sample(void) {
+	uint32_t now = TIM2->CNT;
+
+	if ((TIM2->SR & TIM_SR_CC2IF) != 0) {
+		uint32_t edge = TIM2->CCR2;		// the read clears CC2IF
+
+		if ((TIM2->CR1 & TIM_CR1_CEN) != 0) {
+			latency_Record(now - edge);
+		}
+	}
+}
+
+#define LATENCY_SAMPLE()	latency_Sample()
+
+#else
+
+#define LATENCY_SAMPLE()	do { } while (0)
+
+#endif // LATENCY_HARNESS
+
+#endif // LATENCY_H_
@@ -0,0 +1,36 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Published measurement values, readable without masking interrupts.
+//
+// The frequency block has a single writer (the frequency task, fed by the
+// EXTI2_3 capture ring) and is guarded by a sequence counter (seqlock):
+// the writer makes the counter odd, stores the fields, then makes it even
+// again. A reader retries if the counter was odd or changed while it
+// copied. The resistance is a single word written only by the pot thread
+// in the io task, so it needs no guard.
+// ----------------------------------------------------------------------------
+
+#ifndef MEAS_H_
+#define MEAS_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t freq;		// Hz
+	uint32_t period;	// TIM2 ticks of the last full period
+	uint32_t edges;		// completed period measurements since reset
+	uint32_t res;		// Ohms
+} meas_Values;
+
+// Frequency task only
+void meas_PublishFreq(uint32_t freq, uint32_t period);
+
+// Pot thread (io task) only
+void meas_PublishRes(uint32_t res);
+
+// Consistent copy of the latest values; safe from thread context at any
+// time, never disables interrupts
+void meas_Read(meas_Values *out);
+
+#endif // MEAS_H_
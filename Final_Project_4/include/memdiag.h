@@ -0,0 +1,57 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// RAM usage, stack high-water mark and stack guard.
+//
+// RAM layout (ldscripts/sections.ld): .data, .bss and .noinit from the
+// bottom, then the heap growing up from _Heap_Begin, and the main stack
+// growing down from the top (__stack). The linker reserves
+// __Main_Stack_Size (1 KB) under __stack; sbrk() keeps the heap below that.
+//
+// memdiag_Init() paints everything between the heap break and the current
+// stack pointer with MEMDIAG_PAINT. The lowest word that no longer holds
+// the pattern is the stack high-water mark; the painted words between it
+// and the heap break are the largest block still free for either side.
+//
+// The guard is the bottom MEMDIAG_GUARD_BYTES of the reserved stack: once
+// the stack reaches into it the stack has less than that left before it
+// leaves its reservation and runs into the heap. memdiag_Check() looks at
+// the guard words (cheap enough for every idle pass) and calls the trip
+// hook once. Nothing is printed with the stack that short: the trip is
+// counted in .noinit RAM, which survives the reset the hook normally does,
+// and the count shows up after the reset as the ram.stack_trips metric
+// next to ram.stack_used and ram.free.
+// ----------------------------------------------------------------------------
+
+#ifndef MEMDIAG_H_
+#define MEMDIAG_H_
+
+#include <stdint.h>
+
+#define MEMDIAG_PAINT		0xC5C5C5C5u
+#ifndef MEMDIAG_GUARD_BYTES
+#define MEMDIAG_GUARD_BYTES	128
+#endif
+
+typedef struct {
+	uint32_t data;			// .data bytes (initialised from flash)
+	uint32_t bss;			// .bss + .noinit bytes
+	uint32_t heap;			// bytes taken by sbrk() (newlib malloc)
+	uint32_t stack_size;	// reserved main stack
+	uint32_t stack_used;	// high-water mark, bytes below __stack
+	uint32_t free;			// never touched: heap break to high-water mark
+	uint32_t trips;			// guard hits since power-on (kept over resets)
+	uint8_t tripped;		// the stack reached the guard
+} memdiag_Info;
+
+// First thing in main(): paint the free RAM. tripped runs (in the
+// context that called memdiag_Check()) when the guard is hit, after the
+// trip has been counted; it should reset at once.
+void memdiag_Init(void (*tripped)(void));
+
+// Nonzero once the stack has reached the guard
+uint8_t memdiag_Check(void);
+
+void memdiag_GetInfo(memdiag_Info *out);
+
+#endif // MEMDIAG_H_
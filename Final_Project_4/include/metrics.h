@@ -0,0 +1,87 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Registry of named counters, gauges and histograms for the console dump.
+//
+// A metric is a plain uint32_t (or uint32_t array) that its module already
+// owns; the registry only records its address and name. Updating one is
+// an ordinary `n++` or store with no call or lock (a load, add and store
+// on the M0), cheap enough to stay in production builds. Each metric must
+// have a single writer context, as with ring.h; readers may see a value
+// that is one update old.
+//
+// Modules describe their metrics in a const metrics_Metric table and link
+// it with metrics_Register() from their init function. The console dumps
+// the registry as key=value text lines ("prefix.name=value", the values of
+// a histogram or record comma separated) or as one binary frame:
+//   A5 5A | version 1 | count (u16) | count entries | sum (u8)
+//   entry: kind (u8) | values (u8) | name length (u8) | name | u32 values
+// all little-endian; sum makes the bytes after A5 5A add up to 0 mod 256.
+// tools/metrics_decode.py reads the binary frame.
+// ----------------------------------------------------------------------------
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdint.h>
+
+#define METRICS_NAME_MAX	24	// prefix + '.' + name
+
+typedef enum {
+	METRICS_COUNTER = 0,	// only ever increases (wraps at 2^32)
+	METRICS_GAUGE,			// current value
+	METRICS_HISTOGRAM,		// buckets uint32_t counts
+	METRICS_READ,			// gauge computed on demand by read()
+	METRICS_RECORD,			// buckets related values, e.g. a stats struct
+} metrics_Kind;
+
+typedef struct {
+	const char *name;
+	uint8_t kind;
+	uint8_t buckets;		// values: METRICS_HISTOGRAM / METRICS_RECORD
+	const volatile uint32_t *value;
+	uint32_t (*read)(void);	// METRICS_READ only
+} metrics_Metric;
+
+#define METRICS_COUNTER_OF(name, var) \
+	{ (name), METRICS_COUNTER, 1, &(var), 0 }
+#define METRICS_GAUGE_OF(name, var) \
+	{ (name), METRICS_GAUGE, 1, &(var), 0 }
+#define METRICS_HISTOGRAM_OF(name, array) \
+	{ (name), METRICS_HISTOGRAM, sizeof(array) / sizeof((array)[0]), \
+			(array), 0 }
+#define METRICS_READ_OF(name, fn) \
+	{ (name), METRICS_READ, 1, 0, (fn) }
+
+typedef struct metrics_Group {
+	const char *prefix;
+	const metrics_Metric *metrics;
+	uint8_t count;
+	struct metrics_Group *next;	// registry list
+} metrics_Group;
+
+// Static group over a metrics_Metric table
+#define METRICS_GROUP(group, prefix, table) \
+	static metrics_Group group = { (prefix), (table), \
+			sizeof(table) / sizeof((table)[0]), 0 }
+
+// Add a group (once; dumps list groups in registration order)
+void metrics_Register(metrics_Group *g);
+
+// Dump position, for output produced a piece at a time
+typedef struct {
+	const metrics_Group *group;
+	uint8_t metric;
+	uint8_t value;			// next value; 0xFF = name not yet written
+	uint8_t stage;			// binary: 0 = header, 1 = entries, 2 = done
+	uint8_t sum;
+} metrics_Cursor;
+
+void metrics_Begin(metrics_Cursor *c);
+
+// Next piece of the dump into buf (at least METRICS_NAME_MAX + 8 bytes);
+// returns its length, 0 once the dump is complete
+uint16_t metrics_Text(metrics_Cursor *c, char *buf, uint16_t size);
+uint16_t metrics_Binary(metrics_Cursor *c, uint8_t *buf, uint16_t size);
+
+#endif // METRICS_H_
@@ -0,0 +1,56 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// SPI2 driver for the 128x64 OLED (CS# = PB8, D/C# = PB9, RES# = PB11).
+// ----------------------------------------------------------------------------
+
+#ifndef OLED_H_
+#define OLED_H_
+
+#include <stdint.h>
+
+#define OLED_WIDTH		128
+#define OLED_PAGES		8		// 8 pages of 8 pixel rows
+#define OLED_COL_OFFSET	2		// panel RAM starts 2 columns in
+
+// D/C# level for oled_WriteRun()
+#define OLED_CMD		0
+#define OLED_DATA		1
+
+// Called from oled_Service() when a run has been clocked out
+typedef void (*oled_DoneCallback)(void);
+
+// Sets up SPI2/DMA and starts the panel reset (swtimer_Init() first). The
+// reset and panel init run as a protothread, and oled_Service() also ends
+// each DMA run: kick is called (software timer or DMA interrupt) whenever
+// oled_Service() can make progress. The panel is ready once oled_Busy()
+// reads 0.
+void oled_config(void (*kick)(void));
+void oled_Service(void);
+
+// One CS# frame of the power-up sequence
+typedef struct {
+	const uint8_t *buf;
+	uint16_t len;
+	uint8_t dc;			// OLED_CMD or OLED_DATA
+	uint8_t repeat;		// nonzero: send buf[0] len times
+} oled_Run;
+
+// Power-up sequence after reset (oled_panel.c): the controller init
+// commands, then GDDRAM cleared page by page. Fills *run with frame step
+// (from 0) and returns 1, or returns 0 past the end. run->buf stays valid
+// until the next call. The firmware and the host emulator both send it.
+uint8_t oled_InitStep(uint8_t step, oled_Run *run);
+
+// Send len bytes from buf as one CS# frame over DMA1 channel 5. buf must
+// stay valid until the run completes. Returns -1 if a run is in progress.
+int oled_WriteRun(uint8_t dc, const uint8_t *buf, uint16_t len);
+
+// Nonzero while a DMA run owns the bus or the panel is still in reset. A
+// run ends when oled_Service() finds SPI2 idle after the DMA interrupt.
+uint8_t oled_Busy(void);
+
+// Completion hook, called from oled_Service() after CS# is released
+void oled_SetDoneCallback(oled_DoneCallback cb);
+
+#endif // OLED_H_
@@ -0,0 +1,44 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// RAM framebuffer for the 128x64 OLED with dirty-span tracking.
+//
+// Drawing only touches the 1 KB buffer in RAM. A byte whose value does not
+// change is not marked dirty, so redrawing identical text costs nothing on
+// the bus. fb_Flush() sends one column span per dirty page as a command run
+// and a data run over the SPI2 DMA path.
+// ----------------------------------------------------------------------------
+
+#ifndef OLED_FB_H_
+#define OLED_FB_H_
+
+#include <stdint.h>
+#include "oled.h"
+
+// Set all pixels off (GDDRAM is cleared the same way by oled_config)
+void fb_Clear(void);
+
+// Mark the whole screen dirty, e.g. after the panel lost its contents
+void fb_Invalidate(void);
+
+// Store one column byte (bit 0 = top row of the page)
+void fb_Write(uint8_t page, uint8_t col, uint8_t bits);
+
+// Read back one column byte
+uint8_t fb_Read(uint8_t page, uint8_t col);
+
+// 8x8 character cell at (page, col): 5x7 glyph from flash + 3 blank columns
+void fb_DrawChar(uint8_t page, uint8_t col, unsigned char c);
+
+// String of 8x8 cells, clipped at the right edge
+void fb_DrawString(uint8_t page, uint8_t col, const unsigned char *s);
+
+// Start sending the dirty spans to the panel over DMA and return at once.
+// Returns the number of bytes queued (command + data) so display traffic
+// can be watched, or 0 if nothing was dirty or a flush is still running.
+uint16_t fb_Flush(void);
+
+// Nonzero until the DMA chain started by fb_Flush() has finished
+uint8_t fb_FlushBusy(void);
+
+#endif // OLED_FB_H_
@@ -0,0 +1,135 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Cycle profiler for hot code zones.
+//
+// The M0 has no DWT cycle counter, so SysTick serves as one: prof.c takes
+// it over from the HAL (HAL_InitTick) and lets it run free over its full
+// 24 bits with no interrupt, one count per core clock. A zone may last up
+// to one wrap, 2^24 cycles (349 ms at 48 MHz). isrtime.h reads the same
+// counter.
+//
+// Zones are fixed, like the IRQs in irq.h: one prof_Id each and a name in
+// prof.c. Bracket the code with PROF_BEGIN(id) / PROF_END(id) in the same
+// block. Each zone keeps count, min, max and total; the total is 32 bits,
+// so it wraps after 2^32 cycles (89 s at 48 MHz) of zone time: call
+// prof_Reset() between measurements. -DPROF_HIST adds a log2 histogram
+// (bucket b counts durations of 2^b to 2^(b+1) - 1 cycles).
+// prof_Report() lists the zones by total time, hottest first.
+//
+// Building with -DPROF_ENABLE turns the zones on. The begin macro is one
+// SysTick read. The end macro adds about 20 cycles for the counters, and
+// 10-15 more with PROF_HIST for the histogram bucket, since the M0 has no
+// CLZ. prof_Init() measures an empty zone, and the report subtracts that
+// overhead. Without the define the macros compile to nothing.
+// ----------------------------------------------------------------------------
+
+#ifndef PROF_H_
+#define PROF_H_
+
+#include <stdint.h>
+#include "cmsis/cmsis_device.h"
+
+#define PROF_BUCKETS	20	// the last one also counts longer zones
+
+typedef enum {
+	PROF_ID_CAPTURE = 0,	// EXTI2_3 frequency edge ISR
+	PROF_ID_FREQ,			// frequency task
+	PROF_ID_TIMERS,			// software timer callbacks
+	PROF_ID_IO,				// driver protothreads
+	PROF_ID_RENDER,			// ui_Render() into the frame buffer
+	PROF_ID_FLUSH,			// fb_Flush() dirty scan and first DMA run
+	PROF_ID_SWEEP_BLOCK,	// sweep block DFT and step (PendSV)
+	PROF_ID_FMT,			// fmt_Bench(): the render formats with fmt.c
+	PROF_ID_SNPRINTF,		// fmt_Bench(): the same with snprintf
+	PROF_COUNT
+} prof_Id;
+
+// Calibrate the zone overhead (PROF_ENABLE only; empty otherwise)
+void prof_Init(void);
+
+// Print the zones, hottest first, on the trace output
+void prof_Report(void);
+
+// Clear every zone
+void prof_Reset(void);
+
+#ifdef PROF_ENABLE
+
+typedef struct {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint32_t total;
+#ifdef PROF_HIST
+	uint16_t hist[PROF_BUCKETS];	// saturating
+#endif
+} prof_Zone;
+
+extern prof_Zone prof_zones[PROF_COUNT];
+
+#ifdef PROF_HIST
+
+// floor(log2(x)) for x > 0 by halving search: no CLZ on the M0
+static inline uint8_t prof_Log2(uint32_t x) {
+	uint8_t b = 0;
+
+	if (x >= 1u << 16) {
+		x >>= 16;
+		b += 16;
+	}
+	if (x >= 1u << 8) {
+		x >>= 8;
+		b += 8;
+	}
+	if (x >= 1u << 4) {
+		x >>= 4;
+		b += 4;
+	}
+	if (x >= 1u << 2) {
+		x >>= 2;
+		b += 2;
+	}
+	if (x >= 1u << 1) {
+		b += 1;
+	}
+	return b;
+}
+
+#endif // PROF_HIST
+
+static inline void prof_Record(prof_Id id, uint32_t start) {
+	// SysTick counts down; the mask absorbs one wrap
+	uint32_t cycles = (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk;
+	prof_Zone *z = &prof_zones[id];
+
+	z->count++;
+	z->total += cycles;
+	if (cycles > z->max) {
+		z->max = cycles;
+	}
+	if (cycles < z->min) {
+		z->min = cycles;
+	}
+#ifdef PROF_HIST
+	uint8_t b = cycles != 0 ? prof_Log2(cycles) : 0;
+	if (b >= PROF_BUCKETS) {
+		b = PROF_BUCKETS - 1;
+	}
+	if (z->hist[b] != 0xFFFF) {
+		z->hist[b]++;
+	}
+#endif
+}
+
+#define PROF_BEGIN(id)	uint32_t prof_start_##id = SysTick->VAL
+#define PROF_END(id)	prof_Record((id), prof_start_##id)
+
+#else
+
+#define PROF_BEGIN(id)	do { } while (0)
+#define PROF_END(id)	do { } while (0)
+
+#endif // PROF_ENABLE
+
+#endif // PROF_H_
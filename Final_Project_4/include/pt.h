@@ -0,0 +1,78 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Protothreads: stackless resumable functions for the I/O drivers.
+//
+// A protothread is an ordinary function that returns instead of blocking.
+// Its only state is the resume point (2 bytes in pt_Thread), so any number
+// of long I/O sequences share the one stack. Each call runs from the last
+// wait to the next one. The resume points are case labels of a switch
+// (Duff's device), which gives three rules:
+//   - local variables do not survive a wait; keep them static or in a
+//     struct the caller owns
+//   - no switch statement in a thread body may contain a wait
+//   - at most one PT_* wait per source line (the label is __LINE__)
+//
+// Threads do not poll. Whatever they wait on (an interrupt, a DMA
+// completion, a software timer) calls a kick function that re-runs them;
+// a thread re-checks its condition, so a spurious run is harmless.
+// ----------------------------------------------------------------------------
+
+#ifndef PT_H_
+#define PT_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint16_t lc;		// resume line, 0 = start
+} pt_Thread;
+
+// Thread function return values
+#define PT_WAITING	0
+#define PT_YIELDED	1
+#define PT_EXITED	2
+#define PT_ENDED	3
+
+// Declare / define a thread: PT_THREAD(name(pt_Thread *pt, ...))
+#define PT_THREAD(decl)		char decl
+
+// Start over at the top on the next call
+#define PT_INIT(pt)			((pt)->lc = 0)
+
+#define PT_BEGIN(pt) \
+	{ char pt_yield_ = 1; (void) pt_yield_; switch ((pt)->lc) { case 0:
+
+#define PT_END(pt) \
+	} PT_INIT(pt); return PT_ENDED; }
+
+// Resume point; internal. The fall into the label is intended (-Wextra).
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define PT_FALLTHROUGH_		__attribute__ ((fallthrough))
+#else
+#define PT_FALLTHROUGH_
+#endif
+#define PT_SET_(pt) \
+	(pt)->lc = __LINE__; PT_FALLTHROUGH_; case __LINE__:
+
+// Return until cond is true (checked at once and on every later call)
+#define PT_WAIT_UNTIL(pt, cond) \
+	do { PT_SET_(pt) if (!(cond)) { return PT_WAITING; } } while (0)
+
+#define PT_WAIT_WHILE(pt, cond)	PT_WAIT_UNTIL((pt), !(cond))
+
+// Give up the CPU once; continue on the next call
+#define PT_YIELD(pt) \
+	do { pt_yield_ = 0; PT_SET_(pt) \
+		if (pt_yield_ == 0) { return PT_YIELDED; } } while (0)
+
+// Run a child thread to completion
+#define PT_WAIT_THREAD(pt, thread)	PT_WAIT_WHILE((pt), PT_SCHEDULE(thread))
+#define PT_SPAWN(pt, child, thread) \
+	do { PT_INIT(child); PT_WAIT_THREAD((pt), (thread)); } while (0)
+
+#define PT_EXIT(pt)			do { PT_INIT(pt); return PT_EXITED; } while (0)
+
+// Nonzero while the thread call result says it has not finished
+#define PT_SCHEDULE(f)		((f) < PT_EXITED)
+
+#endif // PT_H_
@@ -0,0 +1,62 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Lock-free single-producer / single-consumer ring buffers.
+//
+// One side (typically an ISR) only pushes and the other (a task) only pops;
+// neither masks interrupts. head is written only by the producer and tail
+// only by the consumer, both as single 32-bit stores, which the M0 performs
+// atomically. The indices run freely and are masked on use, so the
+// capacity must be a power of two and all of it is usable.
+//
+// Elements are fixed-size byte copies. Reserve/Commit and Peek/Release
+// give direct access to the contiguous part of the buffer instead (for
+// DMA, or to build an element in place).
+// ----------------------------------------------------------------------------
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint8_t *buf;
+	uint32_t mask;			// capacity - 1
+	uint16_t size;			// bytes per element
+	volatile uint32_t head;	// producer: next element written
+	volatile uint32_t tail;	// consumer: next element read
+	uint32_t dropped;		// producer: pushes refused because full
+} ring_Ring;
+
+// Static ring of count elements of type; count must be a power of two
+#define RING_DEFINE(name, type, count) \
+	static type name##_storage[count]; \
+	static ring_Ring name = { (uint8_t *) name##_storage, (count) - 1, \
+			sizeof(type), 0, 0, 0 }
+
+// Returns -1 if count is not a power of two
+int ring_Init(ring_Ring *r, void *buf, uint16_t size, uint32_t count);
+
+// Either side; a snapshot that the other side may change at any time
+uint32_t ring_Count(const ring_Ring *r);
+uint32_t ring_Free(const ring_Ring *r);
+
+// Producer. Push returns -1 (and counts a drop) when full; PushBulk
+// stores as many of the n elements as fit and returns that number.
+int ring_Push(ring_Ring *r, const void *item);
+uint32_t ring_PushBulk(ring_Ring *r, const void *items, uint32_t n);
+
+// Producer, zero-copy: up to *n contiguous free elements; *n is set to
+// the number available (may be less, or 0). Write them, then Commit.
+void* ring_Reserve(ring_Ring *r, uint32_t *n);
+void ring_Commit(ring_Ring *r, uint32_t n);
+
+// Consumer. Pop returns -1 when empty; PopBulk returns the number read.
+int ring_Pop(ring_Ring *r, void *item);
+uint32_t ring_PopBulk(ring_Ring *r, void *items, uint32_t n);
+
+// Consumer, zero-copy: up to *n contiguous stored elements, then Release
+const void* ring_Peek(ring_Ring *r, uint32_t *n);
+void ring_Release(ring_Ring *r, uint32_t n);
+
+#endif // RING_H_
@@ -0,0 +1,64 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Cooperative run-to-completion scheduler.
+//
+// Tasks come from a static table in priority order (first = highest). A
+// task is released when its period elapses or when an ISR posts one of its
+// event flags with sched_Post(). Each pass runs the highest-priority
+// released task to completion and then rescans from the top. When nothing
+// is released the idle hook runs.
+//
+// Per task the scheduler keeps run count, execution time and deadline
+// misses (completion later than deadline_ms after release). Releases and
+// lateness use the millisecond timebase, execution time the microsecond one.
+// The statistics are in the metrics dump as one record per task:
+// sched.<task>=runs,misses,exec_total_us,exec_max_us,late_max_ms
+// ----------------------------------------------------------------------------
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS		8
+
+typedef struct {
+	const char *name;
+	void (*run)(void);
+	uint16_t period_ms;		// 0 = event-driven only
+	uint16_t deadline_ms;	// 0 = no deadline check
+	uint32_t events;		// event flags that release the task
+} sched_Task;
+
+typedef struct {
+	// Metrics record (sched.c): keep these five first and in this order
+	uint32_t runs;
+	uint32_t misses;		// completions after the deadline
+	uint32_t exec_total_us;	// wraps after 71 min of execution
+	uint32_t exec_max_us;
+	uint32_t late_max_ms;	// worst release-to-completion time
+	uint32_t next_release;	// periodic tasks: next due time
+	uint32_t released_at;
+	uint8_t released;		// run at the next opportunity
+} sched_Stats;
+
+// table must stay valid (normally a const array); count <= SCHED_MAX_TASKS
+void sched_Init(const sched_Task *table, uint8_t count);
+
+// Called with nothing to run; may sleep until the next interrupt
+void sched_SetIdleHook(void (*idle)(void));
+
+// Release every task waiting on any of events (safe from any ISR)
+void sched_Post(uint32_t events);
+
+// Run the task loop; never returns
+void sched_Run(void);
+
+// Milliseconds until the next periodic release (0 if one is due now),
+// saturated at 0xFFFF
+uint16_t sched_NextDue(void);
+
+const sched_Stats* sched_GetStats(uint8_t task);
+
+#endif // SCHED_H_
@@ -0,0 +1,53 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Frequency sweep generator with synchronized response measurement.
+//
+// The DAC (PA4) plays a 32-sample sine table paced by TIM6, and the
+// response of the device under test is sampled on PA5 (ADC_IN5) by TIM15
+// at exactly the same rate, so every block holds a whole number of periods.
+// ----------------------------------------------------------------------------
+
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include <stdint.h>
+
+#define SWEEP_MAX_POINTS	100
+#define SWEEP_MIN_FREQ		10		// Hz, TIM6/TIM15 stay within 16 bits
+#define SWEEP_MAX_FREQ		20000	// Hz, 32 samples/period = 640 kSPS ADC
+
+typedef enum {
+	SWEEP_LINEAR = 0, SWEEP_LOG
+} sweep_Scale;
+
+typedef struct {
+	uint32_t freq;		// generated frequency (Hz, after timer rounding)
+	uint16_t amplitude;	// response amplitude (ADC counts, 0-peak)
+} sweep_Point;
+
+// Configure DAC, ADC trigger timer and DMA channels (call once at startup)
+void sweep_Init(void);
+
+// Start a background sweep; returns 0 on success, -1 on bad arguments or
+// when a sweep is already running
+int sweep_Start(uint32_t f_start, uint32_t f_stop, uint16_t points,
+		sweep_Scale scale, uint16_t settle_ms);
+
+// Abort a running sweep and hand the DAC/ADC back to the main loop
+void sweep_Stop(void);
+
+// Nonzero while the sweep owns the DAC and ADC
+uint8_t sweep_IsRunning(void);
+
+// Number of points measured so far (valid while running and after)
+uint16_t sweep_Count(void);
+
+// Number of points requested by the last sweep_Start()
+uint16_t sweep_Points(void);
+
+// Result buffer; sweep_Count() entries are valid (the console "sweep"
+// command lists them)
+const sweep_Point* sweep_Results(void);
+
+#endif // SWEEP_H_
@@ -0,0 +1,59 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Software timers on a hierarchical timer wheel.
+//
+// Four wheels of 64 slots at 1 ms, 64 ms, 4.1 s and 262 s per slot hold
+// any number of one-shot or periodic timers; start and stop are O(1) list
+// operations on caller-owned swtimer_Timer structs. A timer that is due in
+// more than 64 ms sits on an outer wheel and is moved inward as the wheel
+// turns. Delays longer than 2^24 ms (4.6 h) are re-queued until reached.
+//
+// A single TIM3 compare (timer_SetAlarm) is armed for the next slot that
+// holds a timer, or the next cascade, and only calls the kick function
+// given to swtimer_Init(). Callbacks run from swtimer_Service() in task
+// context. With no timers queued no interrupt is armed at all.
+//
+// All functions except the kick are for task context only.
+// ----------------------------------------------------------------------------
+
+#ifndef SWTIMER_H_
+#define SWTIMER_H_
+
+#include <stdint.h>
+
+typedef void (*swtimer_Callback)(void *arg);
+
+typedef struct swtimer_Timer {
+	struct swtimer_Timer *next;
+	struct swtimer_Timer **pprev;	// 0 while not queued
+	uint32_t expires;				// timer_Now() time
+	uint32_t period_ms;				// 0 = one-shot
+	swtimer_Callback callback;
+	void *arg;
+} swtimer_Timer;
+
+// kick: called from the TIM3 interrupt when swtimer_Service() is due,
+// normally a sched_Post()
+void swtimer_Init(void (*kick)(void));
+
+// Set the callback; the timer must not be queued
+void swtimer_Setup(swtimer_Timer *t, swtimer_Callback callback, void *arg);
+
+// (Re)start: first expiry delay_ms from now, then every period_ms if
+// nonzero. A running timer is restarted.
+void swtimer_Start(swtimer_Timer *t, uint32_t delay_ms, uint32_t period_ms);
+
+// Cancel; safe on a timer that is not queued and from callbacks
+void swtimer_Stop(swtimer_Timer *t);
+
+uint8_t swtimer_Pending(const swtimer_Timer *t);
+
+// Turn the wheel up to now and run the expired callbacks
+void swtimer_Service(void);
+
+// Milliseconds until swtimer_Service() next has work (0 = now), saturated
+// at 0xFFFF when no timer is queued
+uint16_t swtimer_NextDue(void);
+
+#endif // SWTIMER_H_
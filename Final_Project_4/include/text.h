@@ -0,0 +1,37 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Multi-size text rendering into the OLED framebuffer.
+//
+// The 5x7 font is scaled by expanding each glyph column through a nibble
+// lookup table (one table read per 4 source rows), and the 16x32 numeric
+// font is a generated table of finished 32-row columns indexed per
+// character (font.h), so no size loops over individual pixels. Text is
+// placed on page boundaries: a size that is N pages tall covers pages
+// page .. page + N - 1.
+// ----------------------------------------------------------------------------
+
+#ifndef TEXT_H_
+#define TEXT_H_
+
+#include <stdint.h>
+
+typedef enum {
+	TEXT_8X8 = 0,	// 5x7 font, 1 page
+	TEXT_12X16,		// 5x7 font at 2x with a narrow gap, 2 pages
+	TEXT_16X16,		// 5x7 font at 2x, 2 pages
+	TEXT_24X24,		// 5x7 font at 3x, 3 pages
+	TEXT_16X32		// numeric font (0-9 . - E r), 4 pages
+} text_Size;
+
+// Draw s at (page, col); characters that do not fit are dropped.
+// Returns the column just after the last character drawn.
+uint8_t text_Draw(uint8_t page, uint8_t col, const char *s, text_Size size);
+
+// Width in columns that text_Draw() would use for s
+uint16_t text_Width(const char *s, text_Size size);
+
+// Height in pages of one line of the given size
+uint8_t text_Pages(text_Size size);
+
+#endif // TEXT_H_
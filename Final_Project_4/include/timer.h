@@ -0,0 +1,74 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// TIM3 timebase: monotonic ms/us clock, wakeup compare and sleeping delay.
+//
+// TIM3 counts microseconds and wraps every 65.536 ms; its update interrupt
+// extends the count in software to a 64-bit microsecond / millisecond
+// time. Every read works from thread context and from any ISR, including
+// ones that preempt the TIM3 update: a wrap that is pending but not yet
+// serviced is accounted for. Interrupts must not stay masked longer than
+// one 65 ms wrap.
+//
+// Differences of the 32-bit reads are wrap-safe: (uint32_t)(now - then).
+// ----------------------------------------------------------------------------
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <stdint.h>
+#include "cmsis/cmsis_device.h"
+
+// TIM3 free-running at 1 MHz with the wrap interrupt enabled
+void timer_Init(void);
+
+// Milliseconds since start-up; wraps after 49.7 days
+uint32_t timer_Now(void);
+uint64_t timer_Now64(void);
+
+// Microseconds since start-up; the 32-bit read wraps after 71.6 minutes
+uint32_t timer_Micros(void);
+uint64_t timer_Micros64(void);
+
+// Microseconds (low 32 bits) at the last wrap, for timer_MicrosFast()
+extern volatile uint32_t timer_wrap_micros;
+
+// timer_Micros() without masking interrupts or 64-bit arithmetic, for
+// hot paths (evtrace.h). A wrap is caught by re-reading the base; one still
+// pending (caller outranks or masks the TIM3 interrupt) by the flag.
+static inline uint32_t timer_MicrosFast(void) {
+	uint32_t base;
+	uint32_t cnt;
+
+	do {
+		base = timer_wrap_micros;
+		cnt = TIM3->CNT;
+	} while (base != timer_wrap_micros);
+	if ((TIM3->SR & TIM_SR_UIF) != 0 && cnt < 0x8000) {
+		cnt += 0x10000;
+	}
+	return base + cnt;
+}
+
+// Blocking delay of ms milliseconds; the core sleeps (WFI) between TIM3
+// compare wakeups instead of spinning
+void timer_sleep(uint32_t ms);
+
+// TIM3 compare interrupt ms from now, used to end a WFI. One compare
+// reaches at most TIMER_WAKEUP_MAX_MS ahead; longer waits wake early
+// and re-arm.
+#define TIMER_WAKEUP_MAX_MS	65
+void timer_ArmWakeup(uint32_t ms);
+void timer_DisarmWakeup(void);
+
+// One-shot callback from the TIM3 interrupt about ms from now (compare
+// channel 2). It may come early (ms is capped at TIMER_WAKEUP_MAX_MS, and
+// timer_Advance() fires it at once), so fn must check the time itself.
+void timer_SetAlarm(uint32_t ms, void (*fn)(void));
+void timer_CancelAlarm(void);
+
+// Add time that passed while TIM3 was stopped (Stop mode); a pending
+// alarm fires so its owner can catch up
+void timer_Advance(uint32_t ms);
+
+#endif // TIMER_H_
@@ -0,0 +1,52 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// USART1 console port (TX = PA9, RX = PA10, AF1), 8N1.
+//
+// Both directions go through ring.h rings, so neither side ever waits on
+// the line. The RXNE interrupt pushes received bytes and the TXE interrupt
+// drains the transmit ring; both call kick when a waiting protothread can
+// continue (a byte arrived, or the transmit ring has room again). The
+// USART runs from the HSI so a received byte also wakes the core from Stop.
+// uart_Write() is the only writer of the transmit ring: run one at a time.
+// ----------------------------------------------------------------------------
+
+#ifndef UART_H_
+#define UART_H_
+
+#include <stdint.h>
+#include "pt.h"
+
+#define UART_RX_SIZE	32		// power of two
+#define UART_TX_SIZE	64		// power of two
+
+typedef struct {
+	pt_Thread pt;
+	const uint8_t *buf;
+	uint16_t left;			// bytes not yet in the transmit ring
+} uart_Writer;
+
+typedef struct {
+	uint32_t rx_dropped;	// receive ring full
+	uint32_t overruns;		// byte lost in the USART (ORE)
+} uart_Stats;
+
+// kick runs in interrupt context
+void uart_Init(uint32_t baud, void (*kick)(void));
+
+// Next received byte, -1 if none
+int uart_Getc(void);
+
+// Queue len bytes of buf; buf must stay valid until uart_Write() ends
+void uart_WriteStart(uart_Writer *w, const void *buf, uint16_t len);
+
+// Ends once every byte is in the transmit ring (not yet on the line)
+PT_THREAD(uart_Write(uart_Writer *w));
+
+// Nonzero until the last queued byte has left the shifter; Stop mode
+// would cut the transmission short
+uint8_t uart_TxBusy(void);
+
+uart_Stats uart_GetStats(void);
+
+#endif // UART_H_
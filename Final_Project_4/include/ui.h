@@ -0,0 +1,31 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Meter screen layout.
+//
+// Pages 0-3: frequency in 16x32 digits, unit below a Freq trend chart
+// Pages 4-5: resistance in 12x16 digits
+// Pages 6-7: Res trend chart, or the sweep progress while a sweep runs
+//
+// Only meas.h, sweep.h and the framebuffer drawing modules are used, so
+// the same screen can be rendered by the host emulator (tools/oled_emu).
+// ----------------------------------------------------------------------------
+
+#ifndef UI_H_
+#define UI_H_
+
+#include <stdint.h>
+
+// Chart sample period; Freq keeps 40 x 0.5 s, Res 128 x 0.2 s of history
+#define UI_SAMPLE_MS	100
+
+void ui_Init(void);
+
+// Feed the trend charts, request a frame when a chart gained a column and
+// wake the display on a significant change (every UI_SAMPLE_MS)
+void ui_Sample(void);
+
+// Draw the current frame into the framebuffer (display_Renderer)
+void ui_Render(void);
+
+#endif // UI_H_
@@ -0,0 +1,61 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Interrupt-driven single conversions on ADC1 as a protothread.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "adc.h"
+#include "irq.h"
+
+static void (*adc_kick)(void) = 0;
+
+void adc_Init(void (*kick)(void)) {
+	adc_kick = kick;
+	ADC1->IER = 0;
+	NVIC_EnableIRQ(ADC1_COMP_IRQn);
+}
+
+PT_THREAD(adc_Read(pt_Thread *pt, uint16_t *out)) {
+	PT_BEGIN(pt);
+
+	// ADEN is set at start-up; the first read may find it still settling
+	if ((ADC1->ISR & ADC_ISR_ADRDY) == 0) {
+		ADC1->IER |= ADC_IER_ADRDYIE;
+		PT_WAIT_UNTIL(pt, (ADC1->ISR & ADC_ISR_ADRDY) != 0);
+	}
+
+	// ADSTART is clear here: a single conversion clears it at EOC, and
+	// sweep_Release stops the ADC before handing it back
+	ADC1->ISR = ADC_ISR_EOC | ADC_ISR_OVR;
+	ADC1->IER |= ADC_IER_EOCIE;
+	ADC1->CR |= ADC_CR_ADSTART;
+
+	PT_WAIT_UNTIL(pt, (ADC1->ISR & ADC_ISR_EOC) != 0);
+	*out = (uint16_t) ADC1->DR;		// reading DR clears EOC
+
+	PT_END(pt);
+}
+
+// The sweep owns ADC1->CR by now and has already stopped the conversion
+void adc_Cancel(void) {
+	ADC1->IER &= ~(ADC_IER_ADRDYIE | ADC_IER_EOCIE);
+}
+
+// The flag stays set until the thread reads DR, so the interrupt source is
+// disabled here and the thread finds the flag on its next run
+void ADC1_COMP_IRQHandler(void) {
+	IRQ_ENTER();
+
+	uint32_t ready = ADC1->ISR & ADC1->IER
+			& (ADC_ISR_ADRDY | ADC_ISR_EOC);
+
+	if (ready != 0) {
+		ADC1->IER &= ~(ADC_IER_ADRDYIE | ADC_IER_EOCIE);
+		if (adc_kick) {
+			adc_kick();
+		}
+	}
+
+	IRQ_EXIT(IRQ_ID_ADC);
+}
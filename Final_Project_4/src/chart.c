@@ -0,0 +1,207 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Trend chart widget drawn into the OLED framebuffer.
+// ----------------------------------------------------------------------------
+
+#include "chart.h"
+#include "oled_fb.h"
+
+#define NONE	0xFF
+
+void chart_Init(chart_Chart *chart, chart_Bucket *ring, uint8_t width,
+		uint8_t page, uint8_t col, uint8_t pages, uint8_t decimation,
+		chart_Mode mode) {
+	if (pages == 0) {
+		pages = 1;
+	} else if (pages > CHART_MAX_PAGES) {
+		pages = CHART_MAX_PAGES;
+	}
+	chart->ring = ring;
+	chart->width = width;
+	chart->page = page;
+	chart->col = col;
+	chart->pages = pages;
+	chart->mode = mode;
+	chart->decimation = decimation ? decimation : 1;
+	chart_Clear(chart);
+}
+
+void chart_Clear(chart_Chart *chart) {
+	chart->head = 0;
+	chart->count = 0;
+	chart->pending = 0;
+	chart->acc_n = 0;
+	chart->axis_lo = 0;
+	chart->axis_hi = 0;
+	chart->scale = 0;
+	chart->redraw = 1;
+}
+
+void chart_Invalidate(chart_Chart *chart) {
+	chart->redraw = 1;
+}
+
+void chart_Axis(const chart_Chart *chart, uint16_t *lo, uint16_t *hi) {
+	*lo = chart->axis_lo;
+	*hi = chart->axis_hi;
+}
+
+static inline uint8_t chart_Prev(const chart_Chart *chart, uint8_t idx) {
+	return idx == 0 ? chart->width - 1 : idx - 1;
+}
+
+// Refit the axis to the buckets in the ring when the new bucket falls
+// outside it or the data has shrunk to under a quarter of it
+static void chart_Autoscale(chart_Chart *chart, const chart_Bucket *b) {
+	uint16_t lo = b->lo;
+	uint16_t hi = b->hi;
+	uint8_t idx = chart->head;
+
+	for (uint8_t k = 0; k < chart->count; k++) {
+		idx = chart_Prev(chart, idx);
+		if (chart->ring[idx].lo < lo) {
+			lo = chart->ring[idx].lo;
+		}
+		if (chart->ring[idx].hi > hi) {
+			hi = chart->ring[idx].hi;
+		}
+	}
+
+	uint16_t axis_span = chart->axis_hi - chart->axis_lo;
+	if (chart->scale != 0 && lo >= chart->axis_lo && hi <= chart->axis_hi
+			&& (uint16_t) (hi - lo) >= (axis_span >> 2)) {
+		return;
+	}
+
+	// 1/8 of the data span as margin above and below
+	uint16_t margin = (uint16_t) (hi - lo) >> 3;
+	if (margin == 0) {
+		margin = 1;
+	}
+	chart->axis_lo = lo > margin ? lo - margin : 0;
+	chart->axis_hi = hi < 0xFFFF - margin ? hi + margin : 0xFFFF;
+
+	// One division per rescale instead of one per column
+	uint32_t rows = chart->pages * 8;
+	chart->scale = ((rows - 1) << 16) / (chart->axis_hi - chart->axis_lo);
+	chart->redraw = 1;
+}
+
+void chart_Add(chart_Chart *chart, uint32_t value) {
+	uint16_t v = value > 0xFFFF ? 0xFFFF : (uint16_t) value;
+
+	if (chart->acc_n == 0) {
+		chart->acc.lo = v;
+		chart->acc.hi = v;
+	} else if (v < chart->acc.lo) {
+		chart->acc.lo = v;
+	} else if (v > chart->acc.hi) {
+		chart->acc.hi = v;
+	}
+	if (++chart->acc_n < chart->decimation) {
+		return;
+	}
+	chart->acc_n = 0;
+
+	chart_Autoscale(chart, &chart->acc);
+
+	chart->ring[chart->head] = chart->acc;
+	chart->head = chart->head + 1 == chart->width ? 0 : chart->head + 1;
+	if (chart->count < chart->width) {
+		chart->count++;
+	}
+	if (chart->pending < chart->width) {
+		chart->pending++;
+	}
+}
+
+// Row (0 = top) of a value inside the axis
+static inline uint8_t chart_Row(const chart_Chart *chart, uint16_t v) {
+	uint32_t y = ((uint32_t) (v - chart->axis_lo) * chart->scale) >> 16;
+	return (uint8_t) (chart->pages * 8 - 1 - y);
+}
+
+// Draw bucket idx at screen column x as a vertical bar from its max to its
+// min, stretched to meet the previous bucket so the trace stays connected
+static void chart_Column(chart_Chart *chart, uint8_t x, uint8_t idx,
+		uint8_t prev) {
+	uint32_t mask = 0;
+
+	if (idx != NONE) {
+		uint8_t top = chart_Row(chart, chart->ring[idx].hi);
+		uint8_t bottom = chart_Row(chart, chart->ring[idx].lo);
+
+		if (prev != NONE) {
+			uint8_t prev_top = chart_Row(chart, chart->ring[prev].hi);
+			uint8_t prev_bottom = chart_Row(chart, chart->ring[prev].lo);
+			if (prev_bottom < top) {
+				top = prev_bottom;
+			} else if (prev_top > bottom) {
+				bottom = prev_top;
+			}
+		}
+		mask = (0xFFFFFFFFu >> (31 - bottom)) & (0xFFFFFFFFu << top);
+	}
+
+	for (uint8_t p = 0; p < chart->pages; p++) {
+		fb_Write(chart->page + p, chart->col + x, (uint8_t) mask);
+		mask >>= 8;
+	}
+}
+
+// Ring index shown at screen column x, or NONE for an empty column
+static uint8_t chart_Index(const chart_Chart *chart, uint8_t x) {
+	if (chart->mode == CHART_SWEEP) {
+		// Column x always shows bucket x; the bucket at the cursor is
+		// blanked so the write position is visible
+		if (x >= chart->count || (chart->count == chart->width
+				&& x == chart->head)) {
+			return NONE;
+		}
+		return x;
+	}
+
+	// Oldest bucket at the left
+	if (x >= chart->count) {
+		return NONE;
+	}
+	uint16_t idx = (uint16_t) chart->head + chart->width - chart->count + x;
+	while (idx >= chart->width) {
+		idx -= chart->width;
+	}
+	return (uint8_t) idx;
+}
+
+static void chart_DrawColumn(chart_Chart *chart, uint8_t x) {
+	uint8_t idx = chart_Index(chart, x);
+	uint8_t prev = x > 0 ? chart_Index(chart, x - 1) : NONE;
+
+	chart_Column(chart, x, idx, idx != NONE ? prev : NONE);
+}
+
+void chart_Draw(chart_Chart *chart) {
+	if (chart->pending == 0 && !chart->redraw) {
+		return;
+	}
+
+	if (chart->redraw || chart->mode == CHART_SCROLL) {
+		// Unchanged columns cost nothing on the bus (fb compare-on-write)
+		for (uint8_t x = 0; x < chart->width; x++) {
+			chart_DrawColumn(chart, x);
+		}
+	} else {
+		// New buckets end just before the cursor: redraw them, blank the
+		// cursor column and drop the connector of the column after it
+		uint8_t x = chart->head;
+		for (uint8_t k = 0; k < chart->pending; k++) {
+			x = chart_Prev(chart, x);
+		}
+		for (uint8_t k = 0; k < chart->pending + 2 && k < chart->width; k++) {
+			chart_DrawColumn(chart, x);
+			x = x + 1 == chart->width ? 0 : x + 1;
+		}
+	}
+	chart->pending = 0;
+	chart->redraw = 0;
+}
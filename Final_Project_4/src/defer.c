@@ -0,0 +1,55 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Deferred work: ISRs queue slow processing for the PendSV handler.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "defer.h"
+#include "irq.h"
+
+static defer_Queue *queues[DEFER_MAX_QUEUES];
+static uint8_t queue_count = 0;
+
+int defer_Register(defer_Queue *q) {
+	if (queue_count >= DEFER_MAX_QUEUES) {
+		return -1;
+	}
+	queues[queue_count++] = q;
+	return 0;
+}
+
+int defer_Post(defer_Queue *q, defer_Fn fn, uint32_t arg) {
+	defer_Work w = { fn, arg };
+
+	if (ring_Push(&q->ring, &w) != 0) {
+		return -1;
+	}
+	uint32_t depth = ring_Count(&q->ring);
+	if (depth > q->max_depth) {
+		q->max_depth = depth;
+	}
+	SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+	return 0;
+}
+
+void PendSV_Handler(void) {
+	IRQ_ENTER();
+	uint8_t ran;
+
+	// Rescan until a full pass finds nothing: items may be posted while
+	// earlier ones run
+	do {
+		ran = 0;
+		for (uint8_t i = 0; i < queue_count; i++) {
+			defer_Work w;
+
+			while (ring_Pop(&queues[i]->ring, &w) == 0) {
+				w.fn(w.arg);
+				ran = 1;
+			}
+		}
+	} while (ran);
+
+	IRQ_EXIT(IRQ_ID_PENDSV);
+}
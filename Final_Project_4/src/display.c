@@ -0,0 +1,280 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Non-blocking display refresh service with idle dimming and panel sleep.
+// ----------------------------------------------------------------------------
+
+#include "display.h"
+#include "oled.h"
+#include "oled_fb.h"
+#include "timer.h"
+#include "swtimer.h"
+#include "prof.h"
+#include "metrics.h"
+
+static display_Renderer renderer = 0;
+static display_Stats stats;
+static uint16_t period_ms = 1000 / DISPLAY_DEFAULT_FPS;
+static uint32_t last_slot;
+static uint32_t flush_start;
+static uint8_t flushing = 0;
+static volatile uint8_t requested = 0;
+static void (*display_kick)(void) = 0;
+static swtimer_Timer service_timer;		// next frame slot or power step
+
+// Power management state
+static display_Power power = DISPLAY_ACTIVE;
+static uint32_t dim_after_ms = DISPLAY_DIM_MS;
+static uint32_t off_after_ms = DISPLAY_OFF_MS;
+static volatile uint8_t activity = 0;	// display_Wake() since last service
+static volatile uint32_t activity_at;	// time of that display_Wake()
+static uint8_t power_cmd[4];
+static uint8_t power_len = 0;			// command bytes waiting for the bus
+static uint8_t waking = 0;				// first frame after wake not shown yet
+static uint8_t frame_now = 0;			// draw without waiting for the slot
+static uint32_t wake_start;
+
+static const metrics_Metric display_metrics[] = {
+	METRICS_COUNTER_OF("frames", stats.frames),
+	METRICS_COUNTER_OF("skipped", stats.skipped),
+	METRICS_COUNTER_OF("dropped", stats.dropped),
+};
+METRICS_GROUP(display_group, "display", display_metrics);
+
+static void display_Kick(void) {
+	if (display_kick) {
+		display_kick();
+	}
+}
+
+static void display_Timer(void *arg) {
+	(void) arg;
+	display_Kick();
+}
+
+void display_Init(display_Renderer render, uint8_t fps, void (*kick)(void)) {
+	renderer = render;
+	display_kick = kick;
+	swtimer_Setup(&service_timer, display_Timer, 0);
+	display_SetFrameRate(fps);
+	last_slot = timer_Now();
+	activity_at = last_slot;
+	requested = 1;
+
+	// The init commands (oled_panel.c) leave the panel at full contrast
+	power_cmd[0] = 0x81;
+	power_cmd[1] = DISPLAY_CONTRAST_ACTIVE;
+	power_len = 2;
+
+	metrics_Register(&display_group);
+	display_Kick();
+}
+
+void display_SetFrameRate(uint8_t fps) {
+	if (fps == 0) {
+		fps = 1;
+	} else if (fps > 50) {
+		fps = 50;
+	}
+	period_ms = 1000 / fps;
+}
+
+void display_SetIdleTimeouts(uint32_t dim_ms, uint32_t off_ms) {
+	dim_after_ms = dim_ms;
+	off_after_ms = off_ms;
+}
+
+void display_Request(void) {
+	requested = 1;
+	display_Kick();
+}
+
+uint8_t display_Wake(void) {
+	activity_at = timer_Now();
+	activity = 1;
+	display_Kick();
+	return power == DISPLAY_OFF;
+}
+
+display_Power display_GetPower(void) {
+	return power;
+}
+
+// Queue the commands for a power state change; sent when the bus is free
+static void display_SetPower(display_Power next) {
+	uint8_t n = 0;
+
+	if (next == power) {
+		return;
+	}
+	if (next == DISPLAY_OFF) {
+		power_cmd[n++] = 0xAE;					// display off (sleep)
+	} else {
+		power_cmd[n++] = 0x81;					// contrast
+		power_cmd[n++] = next == DISPLAY_DIM ?
+				DISPLAY_CONTRAST_DIM : DISPLAY_CONTRAST_ACTIVE;
+		if (power == DISPLAY_OFF) {
+			power_cmd[n++] = 0xAF;				// display on
+			waking = 1;
+			frame_now = 1;
+			wake_start = activity_at;
+			requested = 1;
+		}
+	}
+	power_len = n;
+	power = next;
+}
+
+// Idle time runs from the last display_Wake()
+static void display_PowerService(uint32_t now) {
+	uint32_t idle_ms = now - activity_at;
+
+	if (activity) {
+		activity = 0;
+		display_SetPower(DISPLAY_ACTIVE);
+	} else if (off_after_ms != 0 && idle_ms >= off_after_ms) {
+		display_SetPower(DISPLAY_OFF);
+	} else if (dim_after_ms != 0 && idle_ms >= dim_after_ms
+			&& power == DISPLAY_ACTIVE) {
+		display_SetPower(DISPLAY_DIM);
+	}
+}
+
+// A wake is complete once the panel shows the current frame
+static void display_WakeDone(uint32_t now) {
+	if (waking) {
+		waking = 0;
+		stats.wake_ms = (uint16_t) (now - wake_start);
+		if (stats.wake_ms > stats.wake_max_ms) {
+			stats.wake_max_ms = stats.wake_ms;
+		}
+	}
+}
+
+// Milliseconds until the next power step, or UINT32_MAX if none is due
+static uint32_t display_PowerDue(uint32_t now) {
+	uint32_t idle_ms = now - activity_at;
+	uint32_t due = UINT32_MAX;
+
+	if (power != DISPLAY_OFF && off_after_ms != 0) {
+		due = off_after_ms > idle_ms ? off_after_ms - idle_ms : 0;
+	}
+	if (power == DISPLAY_ACTIVE && dim_after_ms != 0) {
+		uint32_t dim = dim_after_ms > idle_ms ? dim_after_ms - idle_ms : 0;
+		if (dim < due) {
+			due = dim;
+		}
+	}
+	return due;
+}
+
+// Arm the timer for whatever display_Service() has to do next: poll the
+// bus while a flush or power command is out, wait for the slot of a
+// requested frame, or for the next dim/off step. With nothing to do the
+// timer is stopped and the panel costs no wakeups at all.
+static void display_Arm(uint32_t now) {
+	uint32_t delay = display_PowerDue(now);
+
+	if (flushing || power_len != 0) {
+		delay = 1;
+	} else if (power != DISPLAY_OFF && (requested || frame_now)) {
+		uint32_t since = now - last_slot;
+		uint32_t slot = (frame_now || since >= period_ms) ?
+				0 : period_ms - since;
+		if (slot < delay) {
+			delay = slot;
+		}
+	}
+
+	if (delay == UINT32_MAX) {
+		swtimer_Stop(&service_timer);
+	} else {
+		swtimer_Start(&service_timer, delay, 0);
+	}
+}
+
+static void display_Step(uint32_t now) {
+	// Account for a flush that finished since the last call
+	if (flushing && !fb_FlushBusy()) {
+		flushing = 0;
+		stats.frame_ms = (uint16_t) (now - flush_start);
+		display_WakeDone(now);
+	}
+
+	display_PowerService(now);
+
+	// Power commands go out between flushes, without a completion hook
+	if (power_len != 0) {
+		if (flushing || oled_Busy()) {
+			return;
+		}
+		oled_SetDoneCallback(0);
+		if (oled_WriteRun(OLED_CMD, power_cmd, power_len) == 0) {
+			power_len = 0;
+		}
+		return;
+	}
+
+	// Nothing is drawn while the panel is off; GDDRAM keeps the last frame.
+	// Slots without a request pass without rendering or a flush.
+	if (power == DISPLAY_OFF || (!requested && !frame_now)) {
+		return;
+	}
+
+	// The first frame after a wake does not wait for its slot
+	uint8_t due = now - last_slot >= period_ms;
+	if (!due && !frame_now) {
+		return;
+	}
+	if (!flushing && oled_Busy()) {
+		return;		// power command still on the bus
+	}
+	frame_now = 0;
+
+	if (due) {
+		last_slot += period_ms;
+		if (now - last_slot >= period_ms) {
+			// Fell more than a slot behind (e.g. long init); resynchronise
+			last_slot = now;
+		}
+	}
+
+	if (flushing) {
+		stats.dropped++;
+		return;
+	}
+
+	if (requested) {
+		requested = 0;
+		if (renderer) {
+			PROF_BEGIN(PROF_ID_RENDER);
+			renderer();
+			PROF_END(PROF_ID_RENDER);
+		}
+	}
+
+	PROF_BEGIN(PROF_ID_FLUSH);
+	uint16_t sent = fb_Flush();
+	PROF_END(PROF_ID_FLUSH);
+	if (sent == 0) {
+		stats.skipped++;
+		display_WakeDone(now);	// panel already shows this frame
+		return;
+	}
+
+	stats.frames++;
+	stats.bytes = sent;
+	flush_start = now;
+	flushing = 1;
+}
+
+void display_Service(void) {
+	uint32_t now = timer_Now();
+
+	display_Step(now);
+	display_Arm(now);
+}
+
+const display_Stats* display_GetStats(void) {
+	return &stats;
+}
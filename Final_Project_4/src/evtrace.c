@@ -0,0 +1,20 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Binary event trace for hot code (ISRs) in place of trace_printf().
+// ----------------------------------------------------------------------------
+
+#include "evtrace.h"
+
+// In .bss: the header is filled in at start-up rather than costing a
+// flash copy of the whole ring
+evtrace_Log evtrace_log;
+
+void evtrace_Init(void) {
+	evtrace_log.records = EVTRACE_RECORDS;
+	evtrace_log.magic = EVTRACE_MAGIC;
+}
+
+void evtrace_Pause(uint8_t paused) {
+	evtrace_log.paused = paused;
+}
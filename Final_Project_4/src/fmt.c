@@ -0,0 +1,221 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Small number-to-text formatting for the display path.
+// ----------------------------------------------------------------------------
+
+#include "fmt.h"
+
+#ifdef PROF_ENABLE
+#include <stdio.h>
+#include "prof.h"
+#endif
+
+static const uint32_t pow10[10] = { 1, 10, 100, 1000, 10000, 100000,
+		1000000, 10000000, 100000000, 1000000000 };
+
+// Number of decimal digits in v (1 for 0)
+static uint8_t fmt_Count(uint32_t v) {
+	uint8_t n = 1;
+	while (n < 10 && v >= pow10[n]) {
+		n++;
+	}
+	return n;
+}
+
+// Exactly n digits of v, most significant first (n >= fmt_Count(v))
+static void fmt_Extract(char *out, uint32_t v, uint8_t n) {
+	for (uint8_t i = n - 1; i > 0; i--) {
+		uint32_t p = pow10[i];
+		char d = '0';
+		while (v >= p) {
+			v -= p;
+			d++;
+		}
+		*out++ = d;
+	}
+	*out = '0' + (char) v;
+}
+
+// Copy len body characters right-aligned in width, with an optional sign
+// ahead of '0' padding or behind ' ' padding
+static uint8_t fmt_Finish(char *buf, const char *body, uint8_t len,
+		uint8_t negative, uint8_t width, char pad) {
+	uint8_t total = len + negative;
+	uint8_t i = 0;
+
+	if (negative && pad == '0') {
+		buf[i++] = '-';
+	}
+	while (total < width) {
+		buf[i++] = pad;
+		total++;
+	}
+	if (negative && pad != '0') {
+		buf[i++] = '-';
+	}
+	for (uint8_t k = 0; k < len; k++) {
+		buf[i++] = body[k];
+	}
+	buf[i] = '\0';
+	return i;
+}
+
+static inline uint32_t fmt_Magnitude(int32_t value) {
+	return value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+}
+
+uint8_t fmt_Unsigned(char *buf, uint32_t value, uint8_t width, char pad) {
+	char digits[10];
+	uint8_t n = fmt_Count(value);
+
+	fmt_Extract(digits, value, n);
+	return fmt_Finish(buf, digits, n, 0, width, pad);
+}
+
+uint8_t fmt_Signed(char *buf, int32_t value, uint8_t width, char pad) {
+	char digits[10];
+	uint32_t magnitude = fmt_Magnitude(value);
+	uint8_t n = fmt_Count(magnitude);
+
+	fmt_Extract(digits, magnitude, n);
+	return fmt_Finish(buf, digits, n, value < 0, width, pad);
+}
+
+uint8_t fmt_Fixed(char *buf, int32_t value, uint8_t decimals, uint8_t width) {
+	char digits[10];
+	char body[11];
+	uint32_t magnitude = fmt_Magnitude(value);
+	uint8_t n = fmt_Count(magnitude);
+	uint8_t len = 0;
+
+	if (decimals > 9) {
+		decimals = 9;
+	}
+	// Always at least one integer digit: 5 with 2 decimals -> "005"
+	if (n <= decimals) {
+		n = decimals + 1;
+	}
+	fmt_Extract(digits, magnitude, n);
+
+	for (uint8_t k = 0; k < n; k++) {
+		if (k == n - decimals) {
+			body[len++] = '.';
+		}
+		body[len++] = digits[k];
+	}
+	return fmt_Finish(buf, body, len, value < 0, width, ' ');
+}
+
+// Digits ahead of the decimal point when n digits are grouped by 3, and
+// the number of groups dropped (the SI prefix)
+static uint8_t fmt_Integer(uint8_t n, uint8_t *group) {
+	*group = 0;
+	while (n > 3) {
+		n -= 3;
+		(*group)++;
+	}
+	return n;
+}
+
+uint8_t fmt_SI(char *buf, uint32_t value, uint8_t digits, uint8_t width,
+		char *prefix) {
+	static const char prefixes[4] = { ' ', 'k', 'M', 'G' };
+	char all[11];
+	char body[12];
+	uint8_t n = fmt_Count(value);
+	uint8_t len = 0;
+	uint8_t group;
+	uint8_t integer;
+
+	if (n <= 3) {
+		*prefix = ' ';
+		return fmt_Unsigned(buf, value, width, ' ');
+	}
+
+	// The integer digits are always kept, so round no higher than them
+	integer = fmt_Integer(n, &group);
+	if (digits < integer) {
+		digits = integer;
+	}
+	if (digits > n) {
+		digits = n;
+	}
+
+	// Round half up on the digit string, so values near UINT32_MAX cannot
+	// overflow. A carry out of the top digit (99999 -> 100000) adds one.
+	all[0] = '0';
+	fmt_Extract(&all[1], value, n);
+	if (digits < n && all[1 + digits] >= '5') {
+		uint8_t k = digits;
+		while (all[k] == '9') {
+			all[k--] = '0';
+		}
+		all[k]++;
+	}
+	const char *top = &all[1];
+	if (all[0] != '0') {
+		top = &all[0];
+		n++;
+	}
+
+	integer = fmt_Integer(n, &group);
+	if (digits < integer) {
+		digits = integer;
+	}
+	*prefix = prefixes[group];
+
+	for (uint8_t k = 0; k < digits; k++) {
+		if (k == integer) {
+			body[len++] = '.';
+		}
+		body[len++] = top[k];
+	}
+	return fmt_Finish(buf, body, len, 0, width, ' ');
+}
+
+#ifdef PROF_ENABLE
+
+// Frequencies and resistances across the display range, plus the edges
+static const uint32_t bench_values[] = { 0, 7, 42, 999, 1000, 4999, 5000,
+		12345, 65535, 99999, 100000, 999999, 1000000 };
+
+#define BENCH_COUNT	(sizeof(bench_values) / sizeof(bench_values[0]))
+
+// Each zone is one ui_Render() worth of number formatting: the frequency
+// and resistance fields and the sweep progress line. The snprintf side is
+// what the render path used before fmt.c; fmt_SI's rounding has no
+// printf equivalent, so the plain %5u frequency stands in for it.
+void fmt_Bench(void) {
+	uint32_t primask = __get_PRIMASK();
+	char buf[20];
+	char prefix;
+
+	__disable_irq();
+	for (uint8_t i = 0; i < BENCH_COUNT; i++) {
+		uint32_t v = bench_values[i];
+		uint32_t count = v % 1000;
+
+		PROF_BEGIN(PROF_ID_FMT);
+		fmt_SI(buf, v, 4, 5, &prefix);
+		fmt_Unsigned(buf, v, 5, ' ');
+		fmt_Unsigned(buf, count, 3, ' ');
+		fmt_Unsigned(buf, 999, 3, ' ');
+		PROF_END(PROF_ID_FMT);
+
+		PROF_BEGIN(PROF_ID_SNPRINTF);
+		snprintf(buf, sizeof(buf), "%5u", (unsigned int) v);
+		snprintf(buf, sizeof(buf), "%5u", (unsigned int) v);
+		snprintf(buf, sizeof(buf), "Sweep: %3u/%3u", (unsigned int) count,
+				999u);
+		PROF_END(PROF_ID_SNPRINTF);
+	}
+	__set_PRIMASK(primask);
+}
+
+#else
+
+void fmt_Bench(void) {
+}
+
+#endif // PROF_ENABLE
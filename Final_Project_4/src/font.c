@@ -0,0 +1,73 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Flash-resident fonts built from the *.def font descriptions.
+// ----------------------------------------------------------------------------
+
+#include "font.h"
+
+#define FONT_5X7_FIRST	0x20
+#define FONT_5X7_LAST	0x7F
+#define FONT_5X7_WIDTH	5
+
+// Designated initializers place each glyph by its code, so the description
+// file does not have to be in order and a missing entry stays blank.
+static const uint8_t font_5x7_glyphs[FONT_5X7_LAST - FONT_5X7_FIRST + 1][FONT_5X7_WIDTH] = {
+#define GLYPH(code, c0, c1, c2, c3, c4) \
+	[(code) - FONT_5X7_FIRST] = { c0, c1, c2, c3, c4 },
+#include "font_5x7.def"
+#undef GLYPH
+};
+
+const font_Font font_5x7 = {
+	.glyphs = &font_5x7_glyphs[0][0],
+	.first = FONT_5X7_FIRST,
+	.count = FONT_5X7_LAST - FONT_5X7_FIRST + 1,
+	.width = FONT_5X7_WIDTH,
+	.spacing = 3,	// keeps the 8-column cell of the original table
+};
+
+const uint8_t* font_Glyph(const font_Font *font, unsigned char c) {
+	uint8_t index = (uint8_t) (c - font->first);
+
+	if (index >= font->count) {
+		index = (uint8_t) ('?' - font->first);
+	}
+	return font->glyphs + (uint16_t) index * font->width;
+}
+
+// ~~~ 16x32 numeric font ~~~
+
+#define FONT_NUM_FIRST	0x20
+#define FONT_NUM_LAST	0x7F
+
+enum {
+#define NUMGLYPH(name, code, ...)	FONT_NUM_##name,
+#include "font_16x32.def"
+#undef NUMGLYPH
+	FONT_NUM_GLYPHS
+};
+
+static const uint32_t font_num_columns[FONT_NUM_GLYPHS][FONT_NUM_WIDTH] = {
+#define NUMGLYPH(name, code, ...) \
+	[FONT_NUM_##name] = { __VA_ARGS__ },
+#include "font_16x32.def"
+#undef NUMGLYPH
+};
+
+// Glyph of each code; unlisted codes stay 0, the blank glyph
+static const uint8_t font_num_index[FONT_NUM_LAST - FONT_NUM_FIRST + 1] = {
+#define NUMGLYPH(name, code, ...) \
+	[(code) - FONT_NUM_FIRST] = FONT_NUM_##name,
+#include "font_16x32.def"
+#undef NUMGLYPH
+};
+
+uint32_t font_NumColumn(unsigned char c, uint8_t col) {
+	uint8_t index = (uint8_t) (c - FONT_NUM_FIRST);
+
+	if (index > FONT_NUM_LAST - FONT_NUM_FIRST || col >= FONT_NUM_WIDTH) {
+		return 0;
+	}
+	return font_num_columns[font_num_index[index]][col];
+}
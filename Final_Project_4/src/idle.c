@@ -0,0 +1,256 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Low-power idle between scheduler tasks.
+//
+// See "system/include/cmsis/stm32f051x8.h" for register/bit definitions.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "idle.h"
+#include "timer.h"
+#include "evtrace.h"
+#include "irq.h"
+#include "metrics.h"
+
+#define RTC_PREDIV_S		0x7FFF	// SSR counts LSI cycles down from here
+#define RTC_PREDIV_A		0		// SSR at f_LSI
+#define RTC_ALARM_EXTI		(1u << 17)
+#define LSI_CAPTURES		8
+// Longest Stop asked of the RTC, about one SSR wrap (32768 LSI cycles is
+// 0.65-1.1 s over the LSI range); ms * ticks_per_ms_q16 then fits 32 bits
+// for an LSI up to 65 kHz
+#define STOP_MAX_MS			1000
+
+static uint16_t (*due_fn)(void) = 0;
+static uint8_t (*stop_fn)(void) = 0;
+static idle_Stats stats;
+static uint32_t ticks_per_ms_q16 = 0;	// LSI cycles per ms, Q16
+static uint32_t ms_per_tick_q16 = 0;	// ms per LSI cycle, Q16
+static uint32_t stop_frac = 0;			// sub-ms remainder, Q16
+static volatile uint8_t stop_woke = 0;
+
+static const metrics_Metric idle_metrics[] = {
+	METRICS_COUNTER_OF("sleeps", stats.sleeps),
+	METRICS_COUNTER_OF("stops", stats.stops),
+	METRICS_COUNTER_OF("stop_ms", stats.stop_ms),
+};
+METRICS_GROUP(idle_group, "idle", idle_metrics);
+
+// Count 48 MHz cycles over 8 RTC clock periods with TIM14 (TI1 = RTC_CLK)
+static uint32_t idle_MeasureLsi(void) {
+	uint32_t total = 0;
+	uint16_t last = 0;
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM14EN;
+	TIM14->CR1 = 0;
+	TIM14->PSC = 0;
+	TIM14->ARR = 0xFFFF;
+	TIM14->OR = TIM14_OR_TI1_RMP_0;					// TI1 <- RTC_CLK
+	TIM14->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1PSC;	// TI1, every 8th
+	TIM14->CCER = TIM_CCER_CC1E;
+	TIM14->EGR = TIM_EGR_UG;
+	TIM14->SR = 0;
+	TIM14->CR1 = TIM_CR1_CEN;
+
+	for (uint8_t i = 0; i <= LSI_CAPTURES; i++) {
+		while ((TIM14->SR & TIM_SR_CC1IF) == 0) {
+		}
+		uint16_t now = (uint16_t) TIM14->CCR1;	// clears CC1IF
+		if (i != 0) {
+			total += (uint16_t) (now - last);
+		}
+		last = now;
+	}
+
+	TIM14->CR1 = 0;
+	RCC->APB1ENR &= ~RCC_APB1ENR_TIM14EN;
+
+	// cycles per capture = 8 LSI periods
+	return (SystemCoreClock * 8 * LSI_CAPTURES) / total;
+}
+
+static void idle_RtcInit(void) {
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	PWR->CR |= PWR_CR_DBP;
+
+	RCC->CSR |= RCC_CSR_LSION;
+	while ((RCC->CSR & RCC_CSR_LSIRDY) == 0) {
+	}
+
+	// The RTC clock source can only change after a backup domain reset
+	if ((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_LSI) {
+		RCC->BDCR |= RCC_BDCR_BDRST;
+		RCC->BDCR &= ~RCC_BDCR_BDRST;
+		RCC->BDCR |= RCC_BDCR_RTCSEL_LSI;
+	}
+	RCC->BDCR |= RCC_BDCR_RTCEN;
+
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->ISR |= RTC_ISR_INIT;
+	while ((RTC->ISR & RTC_ISR_INITF) == 0) {
+	}
+	// Two separate writes, PREDIV_S first (RM0091 RTC_PRER)
+	RTC->PRER = RTC_PREDIV_S;
+	RTC->PRER = RTC_PREDIV_S | (RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos);
+	RTC->ISR &= ~RTC_ISR_INIT;
+	RTC->CR = RTC_CR_BYPSHAD;					// read SSR directly
+	RTC->WPR = 0xFF;
+
+	// Alarm A -> EXTI17 rising edge wakes the core from Stop
+	EXTI->IMR |= RTC_ALARM_EXTI;
+	EXTI->RTSR |= RTC_ALARM_EXTI;
+	NVIC_EnableIRQ(RTC_IRQn);
+}
+
+// SSR with the shadow registers bypassed: read until two reads agree
+static uint16_t idle_RtcSubseconds(void) {
+	uint32_t a;
+	uint32_t b = RTC->SSR;
+
+	do {
+		a = b;
+		b = RTC->SSR;
+	} while (a != b);
+	return (uint16_t) a;
+}
+
+static void idle_RtcAlarm(uint16_t ss) {
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	while ((RTC->ISR & RTC_ISR_ALRAWF) == 0) {
+	}
+	// Date, hours, minutes and seconds masked; all 15 SS bits compared
+	RTC->ALRMAR = RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2
+			| RTC_ALRMAR_MSK1;
+	RTC->ALRMASSR = RTC_ALRMASSR_MASKSS | ss;
+	RTC->ISR &= ~RTC_ISR_ALRAF;
+	RTC->CR |= RTC_CR_ALRAE | RTC_CR_ALRAIE;
+	RTC->WPR = 0xFF;
+}
+
+static void idle_RtcAlarmOff(void) {
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	RTC->ISR &= ~RTC_ISR_ALRAF;
+	RTC->WPR = 0xFF;
+	EXTI->PR = RTC_ALARM_EXTI;
+	NVIC_ClearPendingIRQ(RTC_IRQn);
+}
+
+// Stop mode leaves the core on HSI; relock the PLL (its settings survive)
+static void idle_RestoreClock(void) {
+	RCC->CR |= RCC_CR_PLLON;
+	while ((RCC->CR & RCC_CR_PLLRDY) == 0) {
+	}
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW_Msk) | RCC_CFGR_SW_PLL;
+	while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL) {
+	}
+}
+
+void idle_Init(uint16_t (*next_due)(void), uint8_t (*stop_ok)(void)) {
+	due_fn = next_due;
+	stop_fn = stop_ok;
+	metrics_Register(&idle_group);
+
+#ifdef DEBUG
+	// Keep the debugger attached through Sleep and Stop
+	RCC->APB2ENR |= RCC_APB2ENR_DBGMCUEN;
+	DBGMCU->CR |= DBGMCU_CR_DBG_SLEEP | DBGMCU_CR_DBG_STOP;
+#endif
+
+	if (stop_ok == 0) {
+		return;
+	}
+	idle_RtcInit();
+	stats.lsi_hz = idle_MeasureLsi();
+	ticks_per_ms_q16 = (stats.lsi_hz << 16) / 1000;
+	ms_per_tick_q16 = (1000u << 16) / stats.lsi_hz;
+}
+
+static void idle_Sleep(uint16_t ms) {
+	timer_ArmWakeup(ms);
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+	__WFI();
+	timer_DisarmWakeup();
+	stats.sleeps++;
+}
+
+static void idle_Stop(uint16_t ms) {
+	if (ms > STOP_MAX_MS) {
+		ms = STOP_MAX_MS;
+	}
+	uint32_t ticks = (ms * ticks_per_ms_q16) >> 16;
+	if (ticks > RTC_PREDIV_S) {
+		ticks = RTC_PREDIV_S;
+	}
+
+	// SSR counts down and reloads from RTC_PREDIV_S
+	uint16_t start = idle_RtcSubseconds();
+	uint16_t target = (uint16_t) ((start + (RTC_PREDIV_S + 1) - ticks)
+			& RTC_PREDIV_S);
+	idle_RtcAlarm(target);
+
+	PWR->CR = (PWR->CR & ~PWR_CR_PDDS) | PWR_CR_LPDS;	// Stop, LP regulator
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	__WFI();
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	// Masked here, so an EXTI2 edge that woke the core is still pending
+	uint8_t edge = (EXTI->PR & EXTI_PR_PR2) != 0;
+
+	idle_RestoreClock();
+	idle_RtcAlarmOff();
+
+	// TIM3 was stopped: add the RTC-measured time, keeping the remainder
+	uint16_t slept = (uint16_t) ((start + (RTC_PREDIV_S + 1)
+			- idle_RtcSubseconds()) & RTC_PREDIV_S);
+	stop_frac += slept * ms_per_tick_q16;
+	timer_Advance(stop_frac >> 16);
+	evtrace_Event(EVTRACE_STOP, stop_frac >> 16, 0);
+	stats.stop_ms += stop_frac >> 16;
+	stop_frac &= 0xFFFF;
+
+	stats.stops++;
+	stop_woke = edge;
+}
+
+void idle_Enter(void) {
+	// Masked from the check to the WFI: an interrupt in between stays
+	// pending and makes the WFI return at once
+	__disable_irq();
+
+	uint16_t ms = due_fn ? due_fn() : 1;
+	if (ms != 0) {
+		if (ms >= IDLE_STOP_MIN_MS && stop_fn && stop_fn()) {
+			idle_Stop(ms);
+		} else {
+			idle_Sleep(ms);
+		}
+	}
+
+	__enable_irq();
+}
+
+uint8_t idle_TakeStopWake(void) {
+	uint8_t woke = stop_woke;
+	stop_woke = 0;
+	return woke;
+}
+
+const idle_Stats* idle_GetStats(void) {
+	return &stats;
+}
+
+void RTC_IRQHandler(void) {
+	IRQ_ENTER();
+
+	// Alarm only ends Stop mode; idle_Stop() clears it
+	RTC->ISR &= ~RTC_ISR_ALRAF;
+	EXTI->PR = RTC_ALARM_EXTI;
+
+	IRQ_EXIT(IRQ_ID_RTC);
+}
@@ -0,0 +1,81 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Interrupt priority plan and optional latency/duration instrumentation.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "diag/Trace.h"
+#include "irq.h"
+#include "metrics.h"
+
+// Budgets in 48 MHz cycles. A capture may wait for the other capture ISR;
+// TIM3 latency is measured in whole microseconds (48 cycles), EXTI2_3
+// latency only by the LATENCY_HARNESS build (latency.h).
+const irq_Config irq_table[IRQ_COUNT] = {
+	[IRQ_ID_EXTI2_3] = { "exti2_3", EXTI2_3_IRQn, IRQ_PRIO_CAPTURE, 250, 200 },
+	[IRQ_ID_TIM2] = { "tim2", TIM2_IRQn, IRQ_PRIO_CAPTURE, 300, 200 },
+	[IRQ_ID_TIM3] = { "tim3", TIM3_IRQn, IRQ_PRIO_TIMEBASE, 480, 300 },
+	[IRQ_ID_RTC] = { "rtc", RTC_IRQn, IRQ_PRIO_TIMEBASE, 0, 100 },
+	[IRQ_ID_DMA_SPI] = { "dma_spi", DMA1_Channel4_5_IRQn, IRQ_PRIO_IO, 0, 800 },
+	[IRQ_ID_DMA_ADC] = { "dma_adc", DMA1_Channel1_IRQn, IRQ_PRIO_IO, 0, 300 },
+	[IRQ_ID_TIM15] = { "tim15", TIM15_IRQn, IRQ_PRIO_IO, 0, 1000 },
+	[IRQ_ID_ADC] = { "adc", ADC1_COMP_IRQn, IRQ_PRIO_IO, 0, 100 },
+	[IRQ_ID_USART1] = { "usart1", USART1_IRQn, IRQ_PRIO_IO, 0, 300 },
+	[IRQ_ID_EXTI0_1] = { "exti0_1", EXTI0_1_IRQn, IRQ_PRIO_UI, 0, 200 },
+	[IRQ_ID_PENDSV] = { "pendsv", PendSV_IRQn, IRQ_PRIO_UI, 0, 20000 },
+};
+
+#ifdef IRQ_INSTRUMENT
+
+irq_Stats irq_stats[IRQ_COUNT];
+
+// Longest run of each handler in cycles, named after irq_table
+static metrics_Metric irq_metrics[IRQ_COUNT];
+METRICS_GROUP(irq_group, "isr_max", irq_metrics);
+
+static void irq_RegisterMetrics(void) {
+	for (uint8_t i = 0; i < IRQ_COUNT; i++) {
+		irq_metrics[i].name = irq_table[i].name;
+		irq_metrics[i].kind = METRICS_GAUGE;
+		irq_metrics[i].buckets = 1;
+		irq_metrics[i].value = &irq_stats[i].duration.max;
+	}
+	metrics_Register(&irq_group);
+}
+
+#endif // IRQ_INSTRUMENT
+
+void irq_Init(void) {
+	for (uint8_t i = 0; i < IRQ_COUNT; i++) {
+		NVIC_SetPriority(irq_table[i].irq, irq_table[i].priority);
+	}
+#ifdef IRQ_INSTRUMENT
+	irq_RegisterMetrics();
+#endif
+}
+
+#ifdef IRQ_INSTRUMENT
+
+void irq_Report(void) {
+	for (uint8_t i = 0; i < IRQ_COUNT; i++) {
+		const irq_Config *c = &irq_table[i];
+		const irq_Stats *s = &irq_stats[i];
+
+		if (s->duration.count == 0) {
+			continue;
+		}
+		trace_printf("%-8s n=%u dur_max=%u/%u lat_max=%u/%u over=%u%s\n",
+				c->name, (unsigned) s->duration.count,
+				(unsigned) s->duration.max, (unsigned) c->duration_budget,
+				(unsigned) s->latency_max, (unsigned) c->latency_budget,
+				(unsigned) s->over, s->over != 0 ? "  OVER BUDGET" : "");
+	}
+}
+
+#else
+
+void irq_Report(void) {
+}
+
+#endif // IRQ_INSTRUMENT
@@ -0,0 +1,90 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Interrupt latency harness for the EXTI2 frequency input.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "diag/Trace.h"
+#include "latency.h"
+#include "irq.h"
+#include "metrics.h"
+
+#ifdef LATENCY_HARNESS
+
+static uint32_t count = 0;
+static uint32_t min = UINT32_MAX;
+static uint32_t max = 0;
+static uint64_t total = 0;
+static uint32_t hist[LATENCY_BUCKETS];
+
+static const metrics_Metric latency_metrics[] = {
+	METRICS_GAUGE_OF("max", max),
+	METRICS_HISTOGRAM_OF("hist", hist),
+};
+METRICS_GROUP(latency_group, "latency", latency_metrics);
+
+void latency_Init(void) {
+	RCC->AHBENR |= RCC_AHBENR_GPIOBEN;
+
+	// PB3: alternate function 2 = TIM2_CH2, no pull (driven by the jumper)
+	GPIOB->MODER &= ~GPIO_MODER_MODER3;
+	GPIOB->MODER |= GPIO_MODER_MODER3_1;
+	GPIOB->AFR[0] &= ~(0xFu << (3 * 4));
+	GPIOB->AFR[0] |= 0x2u << (3 * 4);
+	GPIOB->PUPDR &= ~GPIO_PUPDR_PUPDR3;
+
+	// CC2 as input capture of TI2, rising edge like EXTI2, no filter or
+	// prescaler; no interrupt, the EXTI2 ISR reads the flag
+	TIM2->CCER &= ~TIM_CCER_CC2E;
+	TIM2->CCMR1 = (TIM2->CCMR1 & ~(TIM_CCMR1_CC2S | TIM_CCMR1_IC2F
+			| TIM_CCMR1_IC2PSC)) | TIM_CCMR1_CC2S_0;
+	TIM2->CCER &= ~(TIM_CCER_CC2P | TIM_CCER_CC2NP);
+	TIM2->CCER |= TIM_CCER_CC2E;
+	TIM2->SR = ~TIM_SR_CC2IF;
+
+	metrics_Register(&latency_group);
+}
+
+void latency_Record(uint32_t cycles) {
+	uint32_t b = cycles / LATENCY_BUCKET_CYCLES;	// power of two: a shift
+
+	count++;
+	total += cycles;
+	if (cycles < min) {
+		min = cycles;
+	}
+	if (cycles > max) {
+		max = cycles;
+	}
+	hist[b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1]++;
+
+	IRQ_LATENCY(IRQ_ID_EXTI2_3, cycles);
+}
+
+void latency_Report(void) {
+	if (count == 0) {
+		trace_printf("latency: no samples (jumper PB2 to PB3?)\n");
+		return;
+	}
+	trace_printf("latency: n=%u min=%u mean=%u max=%u cycles, jitter %u\n",
+			(unsigned) count, (unsigned) min, (unsigned) (total / count),
+			(unsigned) max, (unsigned) (max - min));
+	for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+		if (hist[b] != 0) {
+			trace_printf("  %3u%s %u\n",
+					(unsigned) (b * LATENCY_BUCKET_CYCLES),
+					b == LATENCY_BUCKETS - 1 ? "+" : " ", (unsigned) hist[b]);
+		}
+	}
+}
+
+#else
+
+void latency_Init(void) {
+}
+
+void latency_Report(void) {
+}
+
+#endif // LATENCY_HARNESS
@@ -5,13 +5,32 @@
 
 // ----------------------------------------------------------------------------
 
-#include <stdio.h>
 #include "diag/Trace.h"
 #include <string.h>
 
 #include "cmsis/cmsis_device.h"
 #include "stm32f0xx_hal_spi.h"
-//#include "timer.h"
+#include "timer.h"
+#include "oled.h"
+#include "oled_fb.h"
+#include "ui.h"
+#include "display.h"
+#include "meas.h"
+#include "sweep.h"
+#include "sched.h"
+#include "idle.h"
+#include "swtimer.h"
+#include "ring.h"
+#include "evtrace.h"
+#include "irq.h"
+#include "pt.h"
+#include "adc.h"
+#include "uart.h"
+#include "fmt.h"
+#include "prof.h"
+#include "latency.h"
+#include "memdiag.h"
+#include "metrics.h"
 
 // ----------------------------------------------------------------------------
 //
@@ -58,13 +77,32 @@
 /*** This is partial code for accessing LED Display via SPI interface. ***/
 
 //...
-// Display Defines
-#define OLED_COL_OFFSET 2 //
-
 //Global Variables
-unsigned int Freq = 0;  // Example: measured frequency value (global variable)
-unsigned int Res = 0;   // Example: measured resistance value (global variable)
+// Measured frequency and resistance are published through meas.h
 static volatile uint8_t timerRunning = 0;
+static volatile uint32_t lastEdge = 0;	// timer_Now() at the last EXTI2 edge
+
+// Raw TIM2 period counts, EXTI2 -> frequency task
+RING_DEFINE(captures, uint32_t, 16);
+
+// Capture and pot counters; each has one writer (see metrics.h)
+static uint32_t edges = 0;		// EXTI2 edges
+static uint32_t overflows = 0;	// TIM2 overflows (input too slow)
+static uint32_t too_fast = 0;	// zero-count periods
+static uint32_t pot_samples = 0;	// pot ADC conversions
+
+static const metrics_Metric capture_metrics[] = {
+	METRICS_COUNTER_OF("edges", edges),
+	METRICS_COUNTER_OF("overflows", overflows),
+	METRICS_COUNTER_OF("too_fast", too_fast),
+	METRICS_COUNTER_OF("dropped", captures.dropped),
+};
+METRICS_GROUP(capture_group, "cap", capture_metrics);
+
+static const metrics_Metric adc_metrics[] = {
+	METRICS_COUNTER_OF("samples", pot_samples),
+};
+METRICS_GROUP(adc_group, "adc", adc_metrics);
 
 //ADC Defines
 /* Clock prescaler for TIM2 timer: no prescaling */
@@ -75,16 +113,20 @@ static volatile uint8_t timerRunning = 0;
 #define ADC_bits (4095)
 #define VoltsPerBit VDD/ADC_bits
 
-//Display Functions
-void oled_Write(unsigned char);
-void oled_Write_Cmd(unsigned char);
-void oled_Write_Data(unsigned char);
-void oled_config(void);
-void refresh_OLED(void);
+//Sweep Defines (user button starts/aborts a filter sweep)
+#define SWEEP_F_START 20
+#define SWEEP_F_STOP 20000
+#define SWEEP_POINTS 100
+#define SWEEP_SETTLE_MS 5
 
-//timer3 functions
-static void tim3_init_1ms_tick(void);
-static void timer_sleep(uint16_t ms);
+//Inputs are enabled once the supplies and the panel have settled
+#define INPUT_SETTLE_MS 100
+
+//Pot sampling period and the console port
+#define POT_PERIOD_MS 10
+#define CONSOLE_BAUD 115200
+#define CONSOLE_LINE 32
+#define CONSOLE_DUMP 48		// metrics dump piece
 
 //TIM2 Functions
 void myTIM2_Init(void);
@@ -94,296 +136,371 @@ void EXTI0_ub_Init(void);
 void EXTI0_1_IRQHandler(void);
 void EXTI2_fgen_Init(void);
 
-//set page and columns
-static inline void oled_SetPage(uint8_t page);
-static inline void oled_SetColumn(uint8_t col);
-static void oled_DrawChar(uint8_t page, uint8_t col, unsigned char c);
-static void oled_DrawStrings(uint8_t page, uint8_t col, const unsigned char *s);
-
 //GPIO init functions
 void myGPIOA_Init(void);
 void myGPIOB_Init(void);
 void myGPIOC_Init(void);
 
-SPI_HandleTypeDef SPI_Handle;
-
 /* Clock prescaler for TIM2 timer: no prescaling */
 #define myTIM2_PRESCALER ((uint16_t)0x0000)
 /* Delay count for TIM2 timer: 1/4 sec at 48 MHz */
 #define myTIM2_PERIOD ((uint32_t)12000000)
 
 //
-// LED Display initialization commands
+// Scheduler tasks (run to completion, highest priority first in tasks[])
 //
-unsigned char oled_init_cmds[] = { 0xAE, 0x20, 0x00, 0x40, 0xA0 | 0x01, 0xA8,
-		0x40 - 1, 0xC0 | 0x08, 0xD3, 0x00, 0xDA, 0x32, 0xD5, 0x80, 0xD9, 0x22,
-		0xDB, 0x30, 0x81, 0xFF, 0xA4, 0xA6, 0xAD, 0x30, 0x8D, 0x10, 0xAE | 0x01,
-		0xC0, 0xA0 };
 
-//
-// Character specifications for LED Display (1 row = 8 bytes = 1 ASCII character)
-// Example: to display '4', retrieve 8 data bytes stored in Characters[52][X] row
-//          (where X = 0, 1, ..., 7) and send them one by one to LED Display.
-// Row number = character ASCII code (e.g., ASCII code of '4' is 0x34 = 52)
-//
-unsigned char Characters[][8] = { { 0b00000000, 0b00000000, 0b00000000,
-		0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // SPACE
-		{ 0b00000000, 0b00000000, 0b01011111, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // !
-		{ 0b00000000, 0b00000111, 0b00000000, 0b00000111, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // "
-		{ 0b00010100, 0b01111111, 0b00010100, 0b01111111, 0b00010100,
-				0b00000000, 0b00000000, 0b00000000 },  // #
-		{ 0b00100100, 0b00101010, 0b01111111, 0b00101010, 0b00010010,
-				0b00000000, 0b00000000, 0b00000000 },  // $
-		{ 0b00100011, 0b00010011, 0b00001000, 0b01100100, 0b01100010,
-				0b00000000, 0b00000000, 0b00000000 },  // %
-		{ 0b00110110, 0b01001001, 0b01010101, 0b00100010, 0b01010000,
-				0b00000000, 0b00000000, 0b00000000 },  // &
-		{ 0b00000000, 0b00000101, 0b00000011, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // '
-		{ 0b00000000, 0b00011100, 0b00100010, 0b01000001, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // (
-		{ 0b00000000, 0b01000001, 0b00100010, 0b00011100, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // )
-		{ 0b00010100, 0b00001000, 0b00111110, 0b00001000, 0b00010100,
-				0b00000000, 0b00000000, 0b00000000 },  // *
-		{ 0b00001000, 0b00001000, 0b00111110, 0b00001000, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 },  // +
-		{ 0b00000000, 0b01010000, 0b00110000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // ,
-		{ 0b00001000, 0b00001000, 0b00001000, 0b00001000, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 },  // -
-		{ 0b00000000, 0b01100000, 0b01100000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // .
-		{ 0b00100000, 0b00010000, 0b00001000, 0b00000100, 0b00000010,
-				0b00000000, 0b00000000, 0b00000000 },  // /
-		{ 0b00111110, 0b01010001, 0b01001001, 0b01000101, 0b00111110,
-				0b00000000, 0b00000000, 0b00000000 },  // 0
-		{ 0b00000000, 0b01000010, 0b01111111, 0b01000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // 1
-		{ 0b01000010, 0b01100001, 0b01010001, 0b01001001, 0b01000110,
-				0b00000000, 0b00000000, 0b00000000 },  // 2
-		{ 0b00100001, 0b01000001, 0b01000101, 0b01001011, 0b00110001,
-				0b00000000, 0b00000000, 0b00000000 },  // 3
-		{ 0b00011000, 0b00010100, 0b00010010, 0b01111111, 0b00010000,
-				0b00000000, 0b00000000, 0b00000000 },  // 4
-		{ 0b00100111, 0b01000101, 0b01000101, 0b01000101, 0b00111001,
-				0b00000000, 0b00000000, 0b00000000 },  // 5
-		{ 0b00111100, 0b01001010, 0b01001001, 0b01001001, 0b00110000,
-				0b00000000, 0b00000000, 0b00000000 },  // 6
-		{ 0b00000011, 0b00000001, 0b01110001, 0b00001001, 0b00000111,
-				0b00000000, 0b00000000, 0b00000000 },  // 7
-		{ 0b00110110, 0b01001001, 0b01001001, 0b01001001, 0b00110110,
-				0b00000000, 0b00000000, 0b00000000 },  // 8
-		{ 0b00000110, 0b01001001, 0b01001001, 0b00101001, 0b00011110,
-				0b00000000, 0b00000000, 0b00000000 },  // 9
-		{ 0b00000000, 0b00110110, 0b00110110, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // :
-		{ 0b00000000, 0b01010110, 0b00110110, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // ;
-		{ 0b00001000, 0b00010100, 0b00100010, 0b01000001, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // <
-		{ 0b00010100, 0b00010100, 0b00010100, 0b00010100, 0b00010100,
-				0b00000000, 0b00000000, 0b00000000 },  // =
-		{ 0b00000000, 0b01000001, 0b00100010, 0b00010100, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 },  // >
-		{ 0b00000010, 0b00000001, 0b01010001, 0b00001001, 0b00000110,
-				0b00000000, 0b00000000, 0b00000000 },  // ?
-		{ 0b00110010, 0b01001001, 0b01111001, 0b01000001, 0b00111110,
-				0b00000000, 0b00000000, 0b00000000 },  // @
-		{ 0b01111110, 0b00010001, 0b00010001, 0b00010001, 0b01111110,
-				0b00000000, 0b00000000, 0b00000000 },  // A
-		{ 0b01111111, 0b01001001, 0b01001001, 0b01001001, 0b00110110,
-				0b00000000, 0b00000000, 0b00000000 },  // B
-		{ 0b00111110, 0b01000001, 0b01000001, 0b01000001, 0b00100010,
-				0b00000000, 0b00000000, 0b00000000 },  // C
-		{ 0b01111111, 0b01000001, 0b01000001, 0b00100010, 0b00011100,
-				0b00000000, 0b00000000, 0b00000000 },  // D
-		{ 0b01111111, 0b01001001, 0b01001001, 0b01001001, 0b01000001,
-				0b00000000, 0b00000000, 0b00000000 },  // E
-		{ 0b01111111, 0b00001001, 0b00001001, 0b00001001, 0b00000001,
-				0b00000000, 0b00000000, 0b00000000 },  // F
-		{ 0b00111110, 0b01000001, 0b01001001, 0b01001001, 0b01111010,
-				0b00000000, 0b00000000, 0b00000000 },  // G
-		{ 0b01111111, 0b00001000, 0b00001000, 0b00001000, 0b01111111,
-				0b00000000, 0b00000000, 0b00000000 },  // H
-		{ 0b01000000, 0b01000001, 0b01111111, 0b01000001, 0b01000000,
-				0b00000000, 0b00000000, 0b00000000 },  // I
-		{ 0b00100000, 0b01000000, 0b01000001, 0b00111111, 0b00000001,
-				0b00000000, 0b00000000, 0b00000000 },  // J
-		{ 0b01111111, 0b00001000, 0b00010100, 0b00100010, 0b01000001,
-				0b00000000, 0b00000000, 0b00000000 },  // K
-		{ 0b01111111, 0b01000000, 0b01000000, 0b01000000, 0b01000000,
-				0b00000000, 0b00000000, 0b00000000 },  // L
-		{ 0b01111111, 0b00000010, 0b00001100, 0b00000010, 0b01111111,
-				0b00000000, 0b00000000, 0b00000000 },  // M
-		{ 0b01111111, 0b00000100, 0b00001000, 0b00010000, 0b01111111,
-				0b00000000, 0b00000000, 0b00000000 },  // N
-		{ 0b00111110, 0b01000001, 0b01000001, 0b01000001, 0b00111110,
-				0b00000000, 0b00000000, 0b00000000 },  // O
-		{ 0b01111111, 0b00001001, 0b00001001, 0b00001001, 0b00000110,
-				0b00000000, 0b00000000, 0b00000000 },  // P
-		{ 0b00111110, 0b01000001, 0b01010001, 0b00100001, 0b01011110,
-				0b00000000, 0b00000000, 0b00000000 },  // Q
-		{ 0b01111111, 0b00001001, 0b00011001, 0b00101001, 0b01000110,
-				0b00000000, 0b00000000, 0b00000000 },  // R
-		{ 0b01000110, 0b01001001, 0b01001001, 0b01001001, 0b00110001,
-				0b00000000, 0b00000000, 0b00000000 },  // S
-		{ 0b00000001, 0b00000001, 0b01111111, 0b00000001, 0b00000001,
-				0b00000000, 0b00000000, 0b00000000 },  // T
-		{ 0b00111111, 0b01000000, 0b01000000, 0b01000000, 0b00111111,
-				0b00000000, 0b00000000, 0b00000000 },  // U
-		{ 0b00011111, 0b00100000, 0b01000000, 0b00100000, 0b00011111,
-				0b00000000, 0b00000000, 0b00000000 },  // V
-		{ 0b00111111, 0b01000000, 0b00111000, 0b01000000, 0b00111111,
-				0b00000000, 0b00000000, 0b00000000 },  // W
-		{ 0b01100011, 0b00010100, 0b00001000, 0b00010100, 0b01100011,
-				0b00000000, 0b00000000, 0b00000000 },  // X
-		{ 0b00000111, 0b00001000, 0b01110000, 0b00001000, 0b00000111,
-				0b00000000, 0b00000000, 0b00000000 },  // Y
-		{ 0b01100001, 0b01010001, 0b01001001, 0b01000101, 0b01000011,
-				0b00000000, 0b00000000, 0b00000000 },  // Z
-		{ 0b01111111, 0b01000001, 0b00000000, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // [
-		{ 0b00010101, 0b00010110, 0b01111100, 0b00010110, 0b00010101,
-				0b00000000, 0b00000000, 0b00000000 },  // back slash
-		{ 0b00000000, 0b00000000, 0b00000000, 0b01000001, 0b01111111,
-				0b00000000, 0b00000000, 0b00000000 },  // ]
-		{ 0b00000100, 0b00000010, 0b00000001, 0b00000010, 0b00000100,
-				0b00000000, 0b00000000, 0b00000000 },  // ^
-		{ 0b01000000, 0b01000000, 0b01000000, 0b01000000, 0b01000000,
-				0b00000000, 0b00000000, 0b00000000 },  // _
-		{ 0b00000000, 0b00000001, 0b00000010, 0b00000100, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // `
-		{ 0b00100000, 0b01010100, 0b01010100, 0b01010100, 0b01111000,
-				0b00000000, 0b00000000, 0b00000000 },  // a
-		{ 0b01111111, 0b01001000, 0b01000100, 0b01000100, 0b00111000,
-				0b00000000, 0b00000000, 0b00000000 },  // b
-		{ 0b00111000, 0b01000100, 0b01000100, 0b01000100, 0b00100000,
-				0b00000000, 0b00000000, 0b00000000 },  // c
-		{ 0b00111000, 0b01000100, 0b01000100, 0b01001000, 0b01111111,
-				0b00000000, 0b00000000, 0b00000000 },  // d
-		{ 0b00111000, 0b01010100, 0b01010100, 0b01010100, 0b00011000,
-				0b00000000, 0b00000000, 0b00000000 },  // e
-		{ 0b00001000, 0b01111110, 0b00001001, 0b00000001, 0b00000010,
-				0b00000000, 0b00000000, 0b00000000 },  // f
-		{ 0b00001100, 0b01010010, 0b01010010, 0b01010010, 0b00111110,
-				0b00000000, 0b00000000, 0b00000000 },  // g
-		{ 0b01111111, 0b00001000, 0b00000100, 0b00000100, 0b01111000,
-				0b00000000, 0b00000000, 0b00000000 },  // h
-		{ 0b00000000, 0b01000100, 0b01111101, 0b01000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // i
-		{ 0b00100000, 0b01000000, 0b01000100, 0b00111101, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // j
-		{ 0b01111111, 0b00010000, 0b00101000, 0b01000100, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // k
-		{ 0b00000000, 0b01000001, 0b01111111, 0b01000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // l
-		{ 0b01111100, 0b00000100, 0b00011000, 0b00000100, 0b01111000,
-				0b00000000, 0b00000000, 0b00000000 },  // m
-		{ 0b01111100, 0b00001000, 0b00000100, 0b00000100, 0b01111000,
-				0b00000000, 0b00000000, 0b00000000 },  // n
-		{ 0b00111000, 0b01000100, 0b01000100, 0b01000100, 0b00111000,
-				0b00000000, 0b00000000, 0b00000000 },  // o
-		{ 0b01111100, 0b00010100, 0b00010100, 0b00010100, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 },  // p
-		{ 0b00001000, 0b00010100, 0b00010100, 0b00011000, 0b01111100,
-				0b00000000, 0b00000000, 0b00000000 },  // q
-		{ 0b01111100, 0b00001000, 0b00000100, 0b00000100, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 },  // r
-		{ 0b01001000, 0b01010100, 0b01010100, 0b01010100, 0b00100000,
-				0b00000000, 0b00000000, 0b00000000 },  // s
-		{ 0b00000100, 0b00111111, 0b01000100, 0b01000000, 0b00100000,
-				0b00000000, 0b00000000, 0b00000000 },  // t
-		{ 0b00111100, 0b01000000, 0b01000000, 0b00100000, 0b01111100,
-				0b00000000, 0b00000000, 0b00000000 },  // u
-		{ 0b00011100, 0b00100000, 0b01000000, 0b00100000, 0b00011100,
-				0b00000000, 0b00000000, 0b00000000 },  // v
-		{ 0b00111100, 0b01000000, 0b00111000, 0b01000000, 0b00111100,
-				0b00000000, 0b00000000, 0b00000000 },  // w
-		{ 0b01000100, 0b00101000, 0b00010000, 0b00101000, 0b01000100,
-				0b00000000, 0b00000000, 0b00000000 },  // x
-		{ 0b00001100, 0b01010000, 0b01010000, 0b01010000, 0b00111100,
-				0b00000000, 0b00000000, 0b00000000 },  // y
-		{ 0b01000100, 0b01100100, 0b01010100, 0b01001100, 0b01000100,
-				0b00000000, 0b00000000, 0b00000000 },  // z
-		{ 0b00000000, 0b00001000, 0b00110110, 0b01000001, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // {
-		{ 0b00000000, 0b00000000, 0b01111111, 0b00000000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // |
-		{ 0b00000000, 0b01000001, 0b00110110, 0b00001000, 0b00000000,
-				0b00000000, 0b00000000, 0b00000000 },  // }
-		{ 0b00001000, 0b00001000, 0b00101010, 0b00011100, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 },  // ~
-		{ 0b00001000, 0b00011100, 0b00101010, 0b00001000, 0b00001000,
-				0b00000000, 0b00000000, 0b00000000 }   // <-
+// Scheduler events posted by the ISRs
+#define EV_BUTTON	(1u << 0)	// user button pressed (EXTI0)
+#define EV_FREQ		(1u << 1)	// period captured (EXTI2)
+#define EV_TIMER	(1u << 2)	// software timer due (TIM3 compare)
+#define EV_IO		(1u << 3)	// a driver protothread can continue
+#define EV_DISPLAY	(1u << 4)	// frame requested, display timer due
+
+static void post_Timers(void) {
+	sched_Post(EV_TIMER);
+}
+
+static void post_Io(void) {
+	sched_Post(EV_IO);
+}
+
+static void post_Display(void) {
+	sched_Post(EV_DISPLAY);
+}
+
+// Software timer callback for the protothreads
+static void io_Wake(void *arg) {
+	(void) arg;
+	sched_Post(EV_IO);
+}
+
+// Software timer callbacks
+static void task_Timers(void) {
+	PROF_BEGIN(PROF_ID_TIMERS);
+	swtimer_Service();
+	PROF_END(PROF_ID_TIMERS);
+}
+
+// User button: wake the panel, otherwise start/abort a filter sweep
+static void task_Button(void) {
+	if (display_Wake()) {
+		// The press only woke the panel
+	} else if (sweep_IsRunning()) {
+		sweep_Stop();
+	} else {
+		sweep_Start(SWEEP_F_START, SWEEP_F_STOP, SWEEP_POINTS, SWEEP_LOG,
+		SWEEP_SETTLE_MS);
+	}
+}
+
+// Pot: ADC -> DAC and the resistance reading every POT_PERIOD_MS
+static swtimer_Timer pot_timer;
+
+static PT_THREAD(pot_Thread(pt_Thread *pt)) {
+	static pt_Thread adc;
+	static uint16_t pot_ADC;
+	static uint32_t pot_res;
+	float pot_V = 0;
+
+	PT_BEGIN(pt);
+
+	while (1) {
+		swtimer_Start(&pot_timer, POT_PERIOD_MS, 0);
+		PT_WAIT_WHILE(pt, swtimer_Pending(&pot_timer));
+
+		// The sweep owns the DAC and ADC while it runs
+		if (sweep_IsRunning()) {
+			continue;
+		}
+
+		//Start ADC, continue when the conversion is done
+		PT_INIT(&adc);
+		PT_WAIT_UNTIL(pt, sweep_IsRunning()
+				|| !PT_SCHEDULE(adc_Read(&adc, &pot_ADC)));
+		if (sweep_IsRunning()) {
+			// Started during the conversion and took the ADC over
+			adc_Cancel();
+			continue;
+		}
+
+		pot_samples++;
+
+		//Put ADV value into DAC
+		DAC->DHR12R1 = pot_ADC;
+		// Convert ADC to Voltage
+		pot_V = pot_ADC * VoltsPerBit;
+
+		uint32_t res = pot_V * (5000 / VDD);
+		meas_PublishRes(res);
+		if (res != pot_res) {
+			pot_res = res;
+			display_Request();
+		}
+	}
+
+	PT_END(pt);
+}
+
+// Console: one command per line on USART1. A reply is text, or a binary
+// image (trace) that starts with its own magic number. The metrics dump and
+// the sweep results are longer than any buffer and go out a piece at a
+// time (console_Thread).
+static const char console_help[] =
+		"commands: help, meas, sweep, trace, metrics, metrics bin\r\n";
+
+#define CONSOLE_METRICS_TEXT	1
+#define CONSOLE_METRICS_BIN		2
+#define CONSOLE_SWEEP			3
+
+static uint8_t console_Dump(const char *line) {
+	if (strcmp(line, "metrics") == 0) {
+		return CONSOLE_METRICS_TEXT;
+	}
+	if (strcmp(line, "metrics bin") == 0) {
+		return CONSOLE_METRICS_BIN;
+	}
+	if (strcmp(line, "sweep") == 0) {
+		return CONSOLE_SWEEP;
+	}
+	return 0;
+}
+
+// Next line of the sweep results into buf (CONSOLE_DUMP bytes): the point
+// count, then frequency and amplitude of each measured point. Returns its
+// length, 0 once every point is out. A running sweep lists the points it
+// has so far.
+static uint16_t console_Sweep(uint16_t *at, char *buf) {
+	uint16_t count = sweep_Count();
+	char *p = buf;
+
+	if (*at > count) {
+		return 0;
+	}
+	if (*at == 0) {
+		memcpy(p, "n=", 2);
+		p += 2;
+		p += fmt_Unsigned(p, count, 0, ' ');
+		*p++ = '/';
+		p += fmt_Unsigned(p, sweep_Points(), 0, ' ');
+	} else {
+		const sweep_Point *pt = &sweep_Results()[*at - 1];
+
+		memcpy(p, "f=", 2);
+		p += 2;
+		p += fmt_Unsigned(p, pt->freq, 0, ' ');
+		memcpy(p, " a=", 3);
+		p += 3;
+		p += fmt_Unsigned(p, pt->amplitude, 0, ' ');
+	}
+	memcpy(p, "\r\n", 2);
+	(*at)++;
+	return p + 2 - buf;
+}
+
+static const void* console_Command(const char *line, char *out,
+		uint16_t *len) {
+	meas_Values v;
+	char *p = out;
+
+	if (strcmp(line, "trace") == 0) {
+		// Frozen until the whole log is in the transmit ring
+		evtrace_Pause(1);
+		*len = sizeof(evtrace_log);
+		return &evtrace_log;
+	}
+	if (strcmp(line, "help") == 0) {
+		*len = sizeof(console_help) - 1;
+		return console_help;
+	}
+	if (strcmp(line, "meas") == 0) {
+		meas_Read(&v);
+		memcpy(p, "f=", 2);
+		p += 2;
+		p += fmt_Unsigned(p, v.freq, 0, ' ');
+		memcpy(p, " r=", 3);
+		p += 3;
+		p += fmt_Unsigned(p, v.res, 0, ' ');
+		memcpy(p, "\r\n", 3);
+		*len = p + 2 - out;
+		return out;
+	}
+	*len = 3;
+	return "?\r\n";
+}
+
+static PT_THREAD(console_Thread(pt_Thread *pt)) {
+	static char line[CONSOLE_LINE];
+	static char reply[CONSOLE_LINE];
+	static char dump_buf[CONSOLE_DUMP];
+	static uint8_t len = 0;
+	static uint8_t dump;
+	static metrics_Cursor dump_at;
+	static uint16_t dump_point;
+	static uart_Writer out;
+	static int c;
+	const void *reply_buf;
+	uint16_t reply_len;
+
+	PT_BEGIN(pt);
+
+	while (1) {
+		PT_WAIT_UNTIL(pt, (c = uart_Getc()) >= 0);
+		if (c != '\r' && c != '\n') {
+			// Overlong lines are cut short
+			if (len < sizeof(line) - 1) {
+				line[len++] = (char) c;
+			}
+			continue;
+		}
+		if (len == 0) {
+			continue;
+		}
+		line[len] = '\0';
+		len = 0;
+
+		dump = console_Dump(line);
+		if (dump == CONSOLE_SWEEP) {
+			dump_point = 0;
+			while ((reply_len = console_Sweep(&dump_point, dump_buf)) != 0) {
+				uart_WriteStart(&out, dump_buf, reply_len);
+				PT_WAIT_THREAD(pt, uart_Write(&out));
+			}
+			continue;
+		}
+		if (dump != 0) {
+			metrics_Begin(&dump_at);
+			while ((reply_len = dump == CONSOLE_METRICS_TEXT ?
+					metrics_Text(&dump_at, dump_buf, sizeof(dump_buf)) :
+					metrics_Binary(&dump_at, (uint8_t*) dump_buf,
+							sizeof(dump_buf))) != 0) {
+				uart_WriteStart(&out, dump_buf, reply_len);
+				PT_WAIT_THREAD(pt, uart_Write(&out));
+			}
+			continue;
+		}
+
+		reply_buf = console_Command(line, reply, &reply_len);
+		uart_WriteStart(&out, reply_buf, reply_len);
+		PT_WAIT_THREAD(pt, uart_Write(&out));
+		evtrace_Pause(0);
+	}
+
+	PT_END(pt);
+}
+
+// Driver protothreads, resumed by their interrupts through EV_IO
+static pt_Thread pot_pt;
+static pt_Thread console_pt;
+
+static void task_Io(void) {
+	PROF_BEGIN(PROF_ID_IO);
+	oled_Service();
+	pot_Thread(&pot_pt);
+	console_Thread(&console_pt);
+	PROF_END(PROF_ID_IO);
+}
+
+// Trend charts and activity detection; while a sweep runs, its progress
+static void task_Ui(void) {
+	static uint8_t sweeping = 0;
+	static uint16_t swept;
+
+	if (sweep_IsRunning()) {
+		display_Wake();		// a running sweep keeps the panel on
+		if (!sweeping || sweep_Count() != swept) {
+			sweeping = 1;
+			swept = sweep_Count();
+			display_Request();
+		}
+		return;
+	}
+	if (sweeping) {
+		sweeping = 0;
+		display_Request();	// the Res chart returns
+	}
+	ui_Sample();
+}
+
+// Periods captured by EXTI2 -> published frequency
+static void task_Freq(void) {
+	static uint32_t shown;
+	uint32_t ticks;
+	uint32_t freq = shown;
+
+	PROF_BEGIN(PROF_ID_FREQ);
+	while (ring_Pop(&captures, &ticks) == 0) {
+		// f = timer_clk / ticks
+		freq = SystemCoreClock / ticks + 1;
+		meas_PublishFreq(freq, ticks);
+	}
+	if (freq != shown) {
+		shown = freq;
+		display_Request();
+	}
+	PROF_END(PROF_ID_FREQ);
+}
+
+// Frame pacing and flushing, released by display.c through EV_DISPLAY
+static void task_Display(void) {
+	display_Service();
+}
+
+#ifdef REPORT_TRACE
+// Instrumentation reports over semihosting. Each trace line halts the core
+// until the debugger has read it, and without a debugger the BKPT faults:
+// only for -DREPORT_TRACE builds run under the debugger. Everything else
+// is in the console metrics dump.
+static void task_Report(void) {
+	irq_Report();
+	prof_Report();
+	latency_Report();
+}
+#endif
+
+static const sched_Task tasks[] = {
+	// name, run, period ms, deadline ms, release events
+	{ "button", task_Button, 0, 20, EV_BUTTON },
+	{ "timers", task_Timers, 0, 5, EV_TIMER },
+	{ "io", task_Io, 0, 10, EV_IO },
+	{ "freq", task_Freq, 0, 10, EV_FREQ },
+	{ "display", task_Display, 0, 20, EV_DISPLAY },
+	{ "ui", task_Ui, UI_SAMPLE_MS, 50, 0 },
+#ifdef REPORT_TRACE
+	{ "report", task_Report, 10000, 0, 0 },
+#endif
 };
 
+// Idle until the scheduler or a software timer has work
+static uint16_t next_Due(void) {
+	uint16_t sched = sched_NextDue();
+	uint16_t timers = swtimer_NextDue();
+	return sched < timers ? sched : timers;
+}
+
+// The stack reached its guard: restart before it runs into the heap.
+// memdiag has counted the trip (ram.stack_trips after the reset).
+static void stack_Tripped(void) {
+	NVIC_SystemReset();
+}
+
+// Nothing to run: check the stack guard, then sleep
+static void idle_Hook(void) {
+	memdiag_Check();
+	idle_Enter();
+}
+
+// Input quiet for this long before Stop mode may be used between tasks
+#define STOP_QUIET_MS 1000
+
+// Stop mode halts every clock but the LSI: only when no DMA, sweep or
+// period measurement is in progress and the input has gone quiet
+static uint8_t stop_Allowed(void) {
+	return !sweep_IsRunning() && !oled_Busy() && !fb_FlushBusy()
+			&& !uart_TxBusy() && !timerRunning
+			&& timer_Now() - lastEdge >= STOP_QUIET_MS;
+}
+
 void SystemClock48MHz(void) {
 //
 // Disable the PLL
@@ -422,37 +539,47 @@ void SystemClock48MHz(void) {
 
 }
 
-int main(int argc, char *argv[]) {
-	//Systems Setup
-	HAL_Init();
-	SystemClock48MHz();
-	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN; /* Enable SYSCFG clock */ // RCC_APB2ENR[0] = 1
-	//Timer Init
-	tim3_init_1ms_tick();
-	oled_config();	//Display Init
-	refresh_OLED();
-
+// Frequency capture and button interrupts, once the inputs have settled
+static void inputs_Start(void *arg) {
+	(void) arg;
 
-	//EXTI Init
-
-	timer_sleep(100);
 	myTIM2_Init(); 		// Initialize timer TIM2
+	latency_Init();		// PB3 capture of the PB2 edge (LATENCY_HARNESS)
 	EXTI0_ub_Init();	// Initialize User Button external interrupt
 
 	EXTI2_fgen_Init();	// Initialize Function Generator external interrupt
+}
 
+int main(int argc, char *argv[]) {
+	//Systems Setup
+	memdiag_Init(stack_Tripped);	// paint the free RAM before it is used
+	evtrace_Init();
+	metrics_Register(&capture_group);
+	metrics_Register(&adc_group);
+	HAL_Init();
+	SystemClock48MHz();
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN; /* Enable SYSCFG clock */ // RCC_APB2ENR[0] = 1
+	irq_Init();		// NVIC priorities for every IRQ enabled below
+	prof_Init();	// SysTick cycle counter set up by HAL_Init()
+	fmt_Bench();	// fmt.c vs snprintf cycles, in the first prof report
 
+	//Timer Init
+	timer_Init();
+	swtimer_Init(post_Timers);
+	oled_config(post_Io);	//Display Init
+	ui_Init();
+	display_Init(ui_Render, DISPLAY_DEFAULT_FPS, post_Display);
 
-
+	//EXTI Init, INPUT_SETTLE_MS after start-up (see inputs_Start)
+	static swtimer_Timer settle;
+	swtimer_Setup(&settle, inputs_Start, 0);
+	swtimer_Start(&settle, INPUT_SETTLE_MS, 0);
 
 	//GPIOs Init
 	myGPIOA_Init(); /* Initialize I/O port PA */
 	myGPIOB_Init(); 	// Initialize I/O port PB
 	myGPIOC_Init(); 	// Initialize I/O port PB
 
-	uint32_t pot_ADC;
-	float pot_V = 0;
-
 	//DAC Init
 
 	// Enable perifer clock for GPIO
@@ -466,211 +593,22 @@ int main(int argc, char *argv[]) {
 	// Enable DAC
 	DAC->CR |= DAC_CR_EN1;
 
-	while (1) {
-
-		//Start ADC
-		ADC1->CR |= ADC_CR_ADSTART; //Start ADC ADSTART = 1
-		//Check if ADC is ready
-		while (ADC_ISR_ADRDY != 1) {
-		}
-		//Get ADC Value
-		pot_ADC = ADC1->DR;
-
-		//Put ADV value into DAC
-		DAC->DHR12R1 = pot_ADC;
-		// Convert ADC to Voltage
-		pot_V = pot_ADC * VoltsPerBit;
-		// print ADC Val
-
-		//trace_printf("Pot ADC:  %u \t\t Pot Voltage:  %.3f V \n", pot_ADC,
-				//pot_V);
-
-		Res = pot_V * (5000 / VDD);
-		refresh_OLED();
-
-	}
-
-}
-
-//
-// LED Display Functions
-//
-
-void refresh_OLED(void) {
-	NVIC_DisableIRQ(EXTI2_3_IRQn);
-	// Buffer size = at most 16 characters per PAGE + terminating '\0'
-	unsigned char Buffer[17];
-
-	snprintf(Buffer, sizeof(Buffer), "R: %5u Ohms", Res);
-	/* Buffer now contains your character ASCII codes for LED Display
-	 - select PAGE (LED Display line) and set starting SEG (column)
-	 - for each c = ASCII code = Buffer[0], Buffer[1], ...,
-	 send 8 bytes in Characters[c][0-7] to LED Display
-	 */
-
-	//...
-	oled_DrawStrings(0, 0, Buffer);
-
-	snprintf(Buffer, sizeof(Buffer), "F: %5u Hz", Freq);
-	/* Buffer now contains your character ASCII codes for LED Display
-	 - select PAGE (LED Display line) and set starting SEG (column)
-	 - for each c = ASCII code = Buffer[0], Buffer[1], ...,
-	 send 8 bytes in Characters[c][0-7] to LED Display
-	 */
-
-	//...
-	oled_DrawStrings(1, 0, Buffer);
-
-	/* Wait for ~100 ms (for example) to get ~10 frames/sec refresh rate
-	 - You should use TIM3 to implement this delay (e.g., via polling)
-	 */
-
-	//...
-	NVIC_EnableIRQ(EXTI2_3_IRQn);
-	timer_sleep(100);
+	sweep_Init();
 
+	//Driver protothreads: pot sampling and the USART1 console
+	adc_Init(post_Io);
+	uart_Init(CONSOLE_BAUD, post_Io);
+	swtimer_Setup(&pot_timer, io_Wake, 0);
+	PT_INIT(&pot_pt);
+	PT_INIT(&console_pt);
+	sched_Post(EV_IO);
 
+	idle_Init(next_Due, stop_Allowed);
+	sched_SetIdleHook(idle_Hook);
+	sched_Init(tasks, sizeof(tasks) / sizeof(tasks[0]));
+	sched_Run();
 }
 
-void oled_Write_Cmd(unsigned char cmd) {
-	//... // make PB8 = CS# = 1
-	GPIOB->BSRR |= GPIO_BSRR_BS_8;
-
-	//... // make PB9 = D/C# = 0
-	GPIOB->BSRR |= GPIO_BSRR_BR_9;
-
-	//... // make PB8 = CS# = 0
-	GPIOB->BSRR |= GPIO_BSRR_BR_8;
-
-	oled_Write(cmd);
-
-	//... // make PB8 = CS# = 1
-	GPIOB->BSRR |= GPIO_BSRR_BS_8;
-
-}
-
-void oled_Write_Data(unsigned char data) {
-	//... // make PB8 = CS# = 1
-	GPIOB->BSRR |= GPIO_BSRR_BS_8;
-
-	//... // make PB9 = D/C# = 1
-	GPIOB->BSRR |= GPIO_BSRR_BS_9;
-
-	//... // make PB8 = CS# = 0
-	GPIOB->BSRR |= GPIO_BSRR_BR_8;
-
-	oled_Write(data);
-
-	//... // make PB8 = CS# = 1
-	GPIOB->BSRR |= GPIO_BSRR_BS_8;
-
-}
-
-void oled_Write(unsigned char Value) {
-
-	/* Wait until SPI2 is ready for writing (TXE = 1 in SPI2_SR) */
-
-	while (!(SPI2->SR & SPI_SR_TXE)) {
-	} //wait till SPI beffer is empty
-
-	//...
-
-	/* Send one 8-bit character:
-	 - This function also sets BIDIOE = 1 in SPI2_CR1
-	 */
-	HAL_SPI_Transmit(&SPI_Handle, &Value, 1, HAL_MAX_DELAY);
-
-	/* Wait until transmission is complete (TXE = 1 in SPI2_SR) */
-	while (!(SPI2->SR & SPI_SR_TXE)) {
-	}
-	while (SPI2->SR & SPI_SR_BSY) {
-	}
-
-	//...
-
-}
-
-void oled_config(void) {
-
-// Don't forget to enable GPIOB clock in RCC
-// Don't forget to configure PB13/PB15 as AF0
-// Don't forget to enable SPI2 clock in RCC
-
-	RCC->AHBENR |= RCC_AHBENR_GPIOBEN; //  0x00040000 0b ... 0100 0000 0000 0000 0000, bit 18, RCC_AHBENR[18] = 1
-	RCC->APB1ENR |= RCC_APB1ENR_SPI2EN;	// SPI2 enable
-
-	// step 2, Port B -> AF0 for PB13, PB15
-	GPIOB->MODER |= GPIO_MODER_MODER13_1;
-	GPIOB->MODER |= GPIO_MODER_MODER15_1;
-	GPIOB->AFR[1] = 0;// selecting the 0th alternate function for high end Port B pins
-	GPIOB->MODER |= GPIO_MODER_MODER8_0;	// out
-	GPIOB->MODER |= GPIO_MODER_MODER9_0;	// out
-	GPIOB->MODER |= GPIO_MODER_MODER11_0;	// out
-
-	GPIOB->OTYPER &= ~(GPIO_OTYPER_OT_8 | GPIO_OTYPER_OT_9 | GPIO_OTYPER_OT_11); //set GPIOs outputs as push pull CS, D/C, RES
-	GPIOB->OSPEEDR &= ~(GPIO_OSPEEDR_OSPEEDR13 | GPIO_OSPEEDR_OSPEEDR15
-			| GPIO_OSPEEDR_OSPEEDR8 | //Set SPI bus to slow
-			GPIO_OSPEEDR_OSPEEDR9 | GPIO_OSPEEDR_OSPEEDR11);
-
-	SPI_Handle.Instance = SPI2;
-
-	SPI_Handle.Init.Direction = SPI_DIRECTION_1LINE;
-	SPI_Handle.Init.Mode = SPI_MODE_MASTER;
-	SPI_Handle.Init.DataSize = SPI_DATASIZE_8BIT;
-	SPI_Handle.Init.CLKPolarity = SPI_POLARITY_LOW;
-	SPI_Handle.Init.CLKPhase = SPI_PHASE_1EDGE;
-	SPI_Handle.Init.NSS = SPI_NSS_SOFT;
-	SPI_Handle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256;
-	SPI_Handle.Init.FirstBit = SPI_FIRSTBIT_MSB;
-	SPI_Handle.Init.CRCPolynomial = 7;
-
-//
-// Initialize the SPI interface
-//
-	HAL_SPI_Init(&SPI_Handle);
-
-//
-// Enable the SPI
-//
-	__HAL_SPI_ENABLE(&SPI_Handle);
-
-	/* Reset LED Display (RES# = PB11):
-	 //set up timer
-
-
-	 - make pin PB11 = 0, wait for a few ms
-	 - make pin PB11 = 1, wait for a few ms
-	 */
-	//...
-	GPIOB->BSRR |= GPIO_BSRR_BR_11; 	//make pin PB11 = 0, wait for a few ms
-	timer_sleep(10);				//need to make this TIM3 (using hal timer)
-	GPIOB->BSRR |= GPIO_BSRR_BS_11; 	//make pin PB11 = 1, wait for a few ms
-	timer_sleep(10);
-
-//
-// Send initialization commands to LED Display
-//
-	for (unsigned int i = 0; i < sizeof(oled_init_cmds); i++) {
-		oled_Write_Cmd(oled_init_cmds[i]);
-	}
-
-	/* Fill LED Display data memory (GDDRAM) with zeros:
-	 - for each PAGE = 0, 1, ..., 7
-	 set starting SEG = 0
-	 call oled_Write_Data( 0x00 ) 128 times
-	 */
-
-	//...
-	// After init commands in oled_config()
-	for (uint8_t page = 0; page < 8; page++) {
-		oled_SetPage(page);
-		oled_SetColumn(0);
-		for (uint16_t i = 0; i < 128; i++) {
-			oled_Write_Data(0x00);
-		}
-	}
-
-}
 
 //Timer Functions
 // ~~~ Timer 2 Initialization and IRQ Handler ~~~
@@ -694,17 +632,21 @@ void myTIM2_Init() {
 	TIM2->EGR = TIM_EGR_UG;
 
 	// Optional: enable overflow interrupt to detect very slow signals
-	NVIC_SetPriority(TIM2_IRQn, 0);
 	NVIC_EnableIRQ(TIM2_IRQn);
 	TIM2->DIER |= TIM_DIER_UIE;
 }
 
 void TIM2_IRQHandler() {
+	IRQ_ENTER();
 
 	// Check if update interrupt flag is indeed set
 	if ((TIM2->SR & TIM_SR_UIF) != 0) {
+		// Counting on from 0 at 48 MHz since the overflow
+		IRQ_LATENCY(IRQ_ID_TIM2, TIM2->CNT);
 
-		trace_printf("\n*** Overflow! (input too slow) ***\n");
+		// "*** Overflow! (input too slow) ***" (evtrace_decode.py)
+		overflows++;
+		evtrace_Event(EVTRACE_OVERFLOW, 0, TIM2->CNT);
 
 		// Clear update interrupt flag
 		TIM2->SR &= ~TIM_SR_UIF;
@@ -712,25 +654,8 @@ void TIM2_IRQHandler() {
 		// Stop timer and reset state
 		TIM2->CR1 |= TIM_CR1_CEN;		//timerRunning = 0;
 	}
-}
 
-// ----------------------------------------------------------------------------
-// Tiny TIM3-based blocking delay (~1 ms resolution)
-// ----------------------------------------------------------------------------
-
-static void tim3_init_1ms_tick(void) {
-	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
-	TIM3->PSC = 48000 - 1; // 48 MHz / 48000 = 1 kHz (1 ms tick)
-	TIM3->ARR = 0xFFFF;
-	TIM3->EGR = TIM_EGR_UG;
-	TIM3->CR1 = TIM_CR1_CEN;
-}
-
-static void timer_sleep(uint16_t ms) {
-	uint16_t start = (uint16_t) TIM3->CNT;
-	while ((uint16_t) ((uint16_t) TIM3->CNT - start) < ms) {
-		__NOP();
-	}
+	IRQ_EXIT(IRQ_ID_TIM2);
 }
 
 //EXTI functions
@@ -752,21 +677,24 @@ void EXTI0_ub_Init() {
 	EXTI->IMR |= EXTI_IMR_MR0;
 	EXTI->PR |= EXTI_PR_PR0;
 
-	// Assign EXTI0 interrupt priority = 0 in NVIC
-	NVIC_SetPriority(EXTI0_1_IRQn, 0);
+	// EXTI0 interrupt priority: IRQ_PRIO_UI (irq.c)
 
 	// Enable EXTI0 interrupts in NVIC
 	NVIC_EnableIRQ(EXTI0_1_IRQn);
 }
 
 void EXTI0_1_IRQHandler(void) {
+	IRQ_ENTER();
 
 	if (EXTI->PR & EXTI_PR_PR0) {
 
 		EXTI->PR = EXTI_PR_PR0;   // write-1-to-clear (assignment is fine)
-		trace_printf("btn pressed\n");
+		evtrace_Event(EVTRACE_BUTTON, 0, 0);
+		sched_Post(EV_BUTTON);
 		// GPIOC->ODR ^= (1u << 8); // optional: visible LED proof if PC8 is an output
 	}
+
+	IRQ_EXIT(IRQ_ID_EXTI0_1);
 }
 
 // ----------------------------------------------------------
@@ -787,17 +715,25 @@ void EXTI2_fgen_Init() {
 	// Clear any stale EXTI2 pending flag
 	EXTI->PR |= EXTI_PR_PR2;
 
-	// Assign EXTI2 interrupt priority = 0 in NVIC, then enable
-	NVIC_SetPriority(EXTI2_3_IRQn, 0);
+	// EXTI2 interrupt priority: IRQ_PRIO_CAPTURE (irq.c), then enable
 	NVIC_EnableIRQ(EXTI2_3_IRQn);
 }
 
 void EXTI2_3_IRQHandler() {
+	LATENCY_SAMPLE();	// TIM2 before anything else touches it
+	IRQ_ENTER();
+	PROF_BEGIN(PROF_ID_CAPTURE);
 
 	/* Check if EXTI2 interrupt pending flag is indeed set */
 	if ((EXTI->PR & EXTI_PR_PR2) != 0) {
 
-		if (!timerRunning) {
+		lastEdge = timer_Now();
+		edges++;
+
+		if (idle_TakeStopWake()) {
+			// This edge woke the core from Stop; it was serviced after
+			// the PLL relock, so the next edge starts the measurement
+		} else if (!timerRunning) {
 
 			//trace_printf("Start Timer");
 			// First edge:
@@ -809,26 +745,29 @@ void EXTI2_3_IRQHandler() {
 			timerRunning = 1;
 		} else {
 
-			volatile uint32_t ticks = TIM2->CNT;
+			uint32_t ticks = TIM2->CNT;
 			TIM2->CR1 &= ~TIM_CR1_CEN;
 
 			timerRunning = 0;
 			// Second edge:
 			// - Stop timer
 			// - Read count
-			// - Compute and print period/frequency (integer arithmetic)
+			// - Queue the count; task_Freq computes the frequency
 			//TIM2->CR1 &= ~TIM_CR1_CEN;
 
 			if (ticks != 0U) {
-				// f = timer_clk / ticks ; T_us = ticks * 1e6 / timer_clk
-
-				volatile double f_Hz = (SystemCoreClock / ticks) + 1;
-				volatile double T_us = (1 / f_Hz) * 1e6;
-				//trace_printf("Period: %.0lf us, Freq: %.0lf Hz\n", T_us, f_Hz);
-				Freq = f_Hz;
+				// A full ring drops this period (counted in captures.dropped)
+				if (ring_Push(&captures, &ticks) == 0) {
+					evtrace_Event(EVTRACE_CAPTURE, ring_Count(&captures),
+							ticks);
+				} else {
+					evtrace_Event(EVTRACE_CAPTURE_DROP, 0, ticks);
+				}
+				sched_Post(EV_FREQ);
 			} else {
 
-				trace_printf("Too fast (ticks=0)\n");
+				too_fast++;
+				evtrace_Event(EVTRACE_TOO_FAST, 0, 0);
 			}
 
 			//timerRunning = 0;
@@ -837,45 +776,16 @@ void EXTI2_3_IRQHandler() {
 		// 2. Clear EXTI2 interrupt pending flag (write 1 to clear).
 		EXTI->PR |= EXTI_PR_PR2;
 	}
-}
-
-// -----------------------------------------------------------------
-
-// -----------------
 
-//Display commands
-static inline void oled_SetPage(uint8_t page) {
-	oled_Write_Cmd(0xB0 | (page & 0x07)); // Page 0..7
-}
-
-static inline void oled_SetColumn(uint8_t col) {
-	col += OLED_COL_OFFSET;
-	oled_Write_Cmd(0x00 | (col & 0x0F));       // lower nibble
-	oled_Write_Cmd(0x10 | ((col >> 4) & 0x0F)); // upper nibble
-}
-
-static void oled_DrawChar(uint8_t page, uint8_t col, unsigned char c) {
-	oled_SetPage(page);
-	oled_SetColumn(col);
-
-	for (uint8_t k = 0; k < 8; k++) {
-		oled_Write_Data(Characters[(uint8_t) c][k]);
-	}
-}
-
-static void oled_DrawStrings(uint8_t page, uint8_t col, const unsigned char *s) {
-	uint8_t x = col;
-	for (size_t i = 0; s[i] != '\0' && x <= 120; i++) {
-		oled_DrawChar(page, x, s[i]);
-		x += 8;
-	}
+	PROF_END(PROF_ID_CAPTURE);
+	IRQ_EXIT(IRQ_ID_EXTI2_3);
 }
 
 //ADC Function Definitions
 void myGPIOA_Init() {
 	//	1. RCC: Enable Port A, Enable ADC
 	//	2. PA1 -> analog configuration
-	//	3. ADC1 -> CFGR1[5:3] = 000, [13:12] = 11;	ADC configure register 1
+	//	3. ADC1 -> CFGR1[5:3] = 000, [13:12] = 01;	ADC configure register 1
 	//	4. ADC1 -> SMPR[2:0] = 111, ADC1 -> CHSELR[1] = 1
 	//	5. ADC1 -> CR[0] = 1
 
@@ -898,11 +808,11 @@ void myGPIOA_Init() {
 
 	//Joey's Code End
 
-	// step 3, 0x ... 0011 0000 00OO O000
+	// step 3, 0x ... 0001 0000 00OO O000
 	ADC1->CFGR1 &= ~ADC_CFGR1_RES;		// bits [4:3] = 00
 	ADC1->CFGR1 &= ~ADC_CFGR1_ALIGN;	// bit [5] = 0
 	ADC1->CFGR1 |= ADC_CFGR1_OVRMOD;	// bit [12] = 1
-	ADC1->CFGR1 |= ADC_CFGR1_CONT;		// bit [13] = 1
+	ADC1->CFGR1 &= ~ADC_CFGR1_CONT;		// bit [13] = 0, one conversion per ADSTART (adc.c)
 
 	// step 4, sampling time register, channel selection register
 	ADC1->SMPR |= ADC_SMPR_SMP;				// bits [2:0] = 111
@@ -0,0 +1,43 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Published measurement values, readable without masking interrupts.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "meas.h"
+
+static volatile uint32_t freq_seq = 0;
+static volatile uint32_t freq_hz = 0;
+static volatile uint32_t freq_period = 0;
+static volatile uint32_t freq_edges = 0;
+static volatile uint32_t res_ohms = 0;
+
+void meas_PublishFreq(uint32_t freq, uint32_t period) {
+	freq_seq++;		// odd: update in progress
+	__DMB();
+	freq_hz = freq;
+	freq_period = period;
+	freq_edges++;
+	__DMB();
+	freq_seq++;		// even: stable
+}
+
+void meas_PublishRes(uint32_t res) {
+	res_ohms = res;
+}
+
+void meas_Read(meas_Values *out) {
+	uint32_t seq;
+
+	do {
+		seq = freq_seq;
+		__DMB();
+		out->freq = freq_hz;
+		out->period = freq_period;
+		out->edges = freq_edges;
+		__DMB();
+	} while ((seq & 1) || seq != freq_seq);
+
+	out->res = res_ohms;
+}
@@ -0,0 +1,117 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// RAM usage, stack high-water mark and stack guard.
+// ----------------------------------------------------------------------------
+
+#include <unistd.h>
+#include "cmsis/cmsis_device.h"
+#include "memdiag.h"
+#include "metrics.h"
+
+// Linker script symbols; only their addresses mean anything
+extern uint32_t _sdata, _edata, _sbss, _end_noinit;
+extern uint32_t __stack, __Main_Stack_Limit;
+
+// Words left unpainted below the stack pointer at paint time, for the
+// frames of the interrupts that may come in meanwhile
+#define MEMDIAG_SP_MARGIN	16
+
+// Not cleared by the startup code: the trip count survives a reset and is
+// only trusted while the magic number is intact (lost at power-off)
+#define MEMDIAG_NOINIT_MAGIC	0x4D454D44u	// "MEMD"
+
+static struct {
+	uint32_t magic;
+	uint32_t trips;
+} noinit __attribute__ ((section(".noinit")));
+
+static void (*trip_hook)(void) = 0;
+static uint8_t tripped = 0;
+
+static uint32_t* memdiag_HeapBreak(void) {
+	return (uint32_t *) sbrk(0);
+}
+
+static uint32_t memdiag_StackUsed(void);
+static uint32_t memdiag_Free(void);
+
+static const metrics_Metric memdiag_metrics[] = {
+	METRICS_READ_OF("stack_used", memdiag_StackUsed),
+	METRICS_READ_OF("free", memdiag_Free),
+	METRICS_COUNTER_OF("stack_trips", noinit.trips),
+};
+METRICS_GROUP(memdiag_group, "ram", memdiag_metrics);
+
+void memdiag_Init(void (*hook)(void)) {
+	uint32_t *p = memdiag_HeapBreak();
+	uint32_t *top = (uint32_t *) __get_MSP() - MEMDIAG_SP_MARGIN;
+
+	trip_hook = hook;
+	if (noinit.magic != MEMDIAG_NOINIT_MAGIC) {
+		noinit.magic = MEMDIAG_NOINIT_MAGIC;	// power-on
+		noinit.trips = 0;
+	}
+	while (p < top) {
+		*p++ = MEMDIAG_PAINT;
+	}
+	metrics_Register(&memdiag_group);
+}
+
+uint8_t memdiag_Check(void) {
+	const uint32_t *p = &__Main_Stack_Limit;
+	const uint32_t *end = p + MEMDIAG_GUARD_BYTES / 4;
+
+	if (tripped) {
+		return 1;
+	}
+	while (p < end) {
+		if (*p++ != MEMDIAG_PAINT) {
+			tripped = 1;
+			noinit.trips++;
+			if (trip_hook) {
+				trip_hook();
+			}
+			return 1;
+		}
+	}
+	return 0;
+}
+
+// Lowest word above the heap break that the stack has written
+static const uint32_t* memdiag_HighWater(const uint32_t *heap_break) {
+	const uint32_t *p = heap_break;
+
+	while (p < &__stack && *p == MEMDIAG_PAINT) {
+		p++;
+	}
+	return p;
+}
+
+void memdiag_GetInfo(memdiag_Info *out) {
+	uint32_t *brk = memdiag_HeapBreak();
+	const uint32_t *mark = memdiag_HighWater(brk);
+
+	out->data = (uint32_t) &_edata - (uint32_t) &_sdata;
+	out->bss = (uint32_t) &_end_noinit - (uint32_t) &_sbss;
+	out->heap = (uint32_t) brk - (uint32_t) &_end_noinit;
+	out->stack_size = (uint32_t) &__stack - (uint32_t) &__Main_Stack_Limit;
+	out->stack_used = (uint32_t) &__stack - (uint32_t) mark;
+	out->free = (uint32_t) mark - (uint32_t) brk;
+	out->trips = noinit.trips;
+	out->tripped = tripped;
+}
+
+static uint32_t memdiag_StackUsed(void) {
+	memdiag_Info m;
+
+	memdiag_GetInfo(&m);
+	return m.stack_used;
+}
+
+static uint32_t memdiag_Free(void) {
+	memdiag_Info m;
+
+	memdiag_GetInfo(&m);
+	return m.free;
+}
@@ -0,0 +1,150 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Registry of named counters, gauges and histograms for the console dump.
+// ----------------------------------------------------------------------------
+
+#include "metrics.h"
+#include "fmt.h"
+
+#define METRICS_NAME		0xFF	// cursor value: name not yet written
+#define METRICS_PIECE_MAX	(METRICS_NAME_MAX + 2)
+
+static metrics_Group *groups = 0;
+static metrics_Group *last = 0;
+
+void metrics_Register(metrics_Group *g) {
+	g->next = 0;
+	if (last == 0) {
+		groups = g;
+	} else {
+		last->next = g;
+	}
+	last = g;
+}
+
+// Skip past the end of a group (and empty groups)
+static void metrics_Settle(metrics_Cursor *c) {
+	while (c->group != 0 && c->metric >= c->group->count) {
+		c->group = c->group->next;
+		c->metric = 0;
+	}
+}
+
+void metrics_Begin(metrics_Cursor *c) {
+	c->group = groups;
+	c->metric = 0;
+	c->value = METRICS_NAME;
+	c->stage = 0;
+	c->sum = 0;
+	metrics_Settle(c);
+}
+
+// Move to the next value, or to the next metric after the last one
+static void metrics_Step(metrics_Cursor *c, const metrics_Metric *m) {
+	c->value = c->value == METRICS_NAME ? 0 : c->value + 1;
+	if (c->value >= m->buckets) {
+		c->value = METRICS_NAME;
+		c->metric++;
+		metrics_Settle(c);
+	}
+}
+
+static uint32_t metrics_Value(const metrics_Metric *m, uint8_t i) {
+	if (m->kind == METRICS_READ) {
+		return m->read();
+	}
+	return m->value[i];
+}
+
+// "prefix.name" truncated to METRICS_NAME_MAX; returns its length
+static uint8_t metrics_Name(const metrics_Cursor *c, char *out) {
+	const char *s = c->group->prefix;
+	uint8_t n = 0;
+
+	while (*s != '\0' && n < METRICS_NAME_MAX) {
+		out[n++] = *s++;
+	}
+	if (n < METRICS_NAME_MAX) {
+		out[n++] = '.';
+	}
+	s = c->group->metrics[c->metric].name;
+	while (*s != '\0' && n < METRICS_NAME_MAX) {
+		out[n++] = *s++;
+	}
+	return n;
+}
+
+uint16_t metrics_Text(metrics_Cursor *c, char *buf, uint16_t size) {
+	uint16_t n = 0;
+
+	while (c->group != 0 && size - n >= METRICS_PIECE_MAX) {
+		const metrics_Metric *m = &c->group->metrics[c->metric];
+
+		if (c->value == METRICS_NAME) {
+			n += metrics_Name(c, &buf[n]);
+			buf[n++] = '=';
+		} else {
+			n += fmt_Unsigned(&buf[n], metrics_Value(m, c->value), 0, ' ');
+			if (c->value + 1 < m->buckets) {
+				buf[n++] = ',';
+			} else {
+				buf[n++] = '\r';
+				buf[n++] = '\n';
+			}
+		}
+		metrics_Step(c, m);
+	}
+	return n;
+}
+
+uint16_t metrics_Binary(metrics_Cursor *c, uint8_t *buf, uint16_t size) {
+	uint16_t n = 0;
+	uint16_t from = 0;		// first byte of this piece in the checksum
+	uint16_t i;
+
+	if (c->stage == 0 && size >= 5) {
+		const metrics_Group *g;
+		uint16_t count = 0;
+
+		for (g = groups; g != 0; g = g->next) {
+			count += g->count;
+		}
+		buf[n++] = 0xA5;
+		buf[n++] = 0x5A;
+		buf[n++] = 1;
+		buf[n++] = (uint8_t) count;
+		buf[n++] = (uint8_t) (count >> 8);
+		from = 2;			// sync bytes are not summed
+		c->stage = 1;
+	}
+
+	while (c->stage == 1 && c->group != 0 && size - n >= METRICS_PIECE_MAX + 1) {
+		const metrics_Metric *m = &c->group->metrics[c->metric];
+
+		if (c->value == METRICS_NAME) {
+			buf[n++] = m->kind;
+			buf[n++] = m->buckets;
+			i = n++;
+			buf[i] = metrics_Name(c, (char*) &buf[n]);
+			n += buf[i];
+		} else {
+			uint32_t v = metrics_Value(m, c->value);
+
+			buf[n++] = (uint8_t) v;
+			buf[n++] = (uint8_t) (v >> 8);
+			buf[n++] = (uint8_t) (v >> 16);
+			buf[n++] = (uint8_t) (v >> 24);
+		}
+		metrics_Step(c, m);
+	}
+
+	for (i = from; i < n; i++) {
+		c->sum += buf[i];
+	}
+	if (c->stage == 1 && c->group == 0 && size - n >= 1) {
+		buf[n++] = (uint8_t) -c->sum;
+		c->stage = 2;
+	}
+	return n;
+}
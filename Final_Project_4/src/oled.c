@@ -0,0 +1,223 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// SPI2 driver for the 128x64 OLED (CS# = PB8, D/C# = PB9, RES# = PB11).
+//
+// See "system/include/cmsis/stm32f051x8.h" for register/bit definitions.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "stm32f0xx_hal_spi.h"
+#include "oled.h"
+#include "swtimer.h"
+#include "pt.h"
+#include "irq.h"
+
+#define OLED_RESET_MS			10	// RES# low time, then time to first command
+
+SPI_HandleTypeDef SPI_Handle;
+
+static volatile uint8_t dmaBusy = 0;
+static volatile uint8_t draining = 0;	// DMA done, SPI FIFO still emptying
+static oled_DoneCallback dmaDone = 0;
+static volatile uint8_t resetting = 0;
+static swtimer_Timer reset_timer;
+static pt_Thread reset_pt;
+static void (*oled_kick)(void) = 0;
+
+static int oled_StartRun(uint8_t dc, const uint8_t *buf, uint16_t len,
+		uint32_t minc);
+
+// Software timer and DMA completions resume oled_Service()
+static void oled_Wake(void *arg) {
+	(void) arg;
+	if (oled_kick) {
+		oled_kick();
+	}
+}
+
+// The last bytes of a run leave the TX FIFO / shifter a few microseconds
+// after the DMA transfer completes; CS# is released here once SPI2 is idle
+// rather than waited for in the interrupt. Returns 1 while still draining.
+static uint8_t oled_Drain(void) {
+	if (!draining) {
+		return 0;
+	}
+	if ((SPI2->SR & (SPI_SR_FTLVL | SPI_SR_BSY)) != 0) {
+		oled_Wake(0);		// run again on the next pass
+		return 1;
+	}
+
+	SPI2->CR2 &= ~SPI_CR2_TXDMAEN;
+	GPIOB->BSRR = GPIO_BSRR_BS_8;
+	draining = 0;
+	dmaBusy = 0;
+	if (dmaDone) {
+		dmaDone();			// may start the next run
+	}
+	return 0;
+}
+
+// Reset pulse, init commands and GDDRAM clear without a busy wait: the
+// thread returns while RES# is timed or a DMA run is on the bus
+static PT_THREAD(oled_ResetThread(pt_Thread *pt)) {
+	static uint8_t step;
+	static oled_Run run;
+
+	PT_BEGIN(pt);
+
+	// RES# low (set in oled_config), then high, a few ms each
+	swtimer_Start(&reset_timer, OLED_RESET_MS, 0);
+	PT_WAIT_WHILE(pt, swtimer_Pending(&reset_timer));
+	GPIOB->BSRR = GPIO_BSRR_BS_11;
+	swtimer_Start(&reset_timer, OLED_RESET_MS, 0);
+	PT_WAIT_WHILE(pt, swtimer_Pending(&reset_timer));
+
+	// Init commands and the GDDRAM clear (oled_panel.c); a repeated byte
+	// is sent with the memory address not incremented
+	for (step = 0; oled_InitStep(step, &run); step++) {
+		oled_StartRun(run.dc, run.buf, run.len,
+				run.repeat ? 0 : DMA_CCR_MINC);
+		PT_WAIT_WHILE(pt, dmaBusy);
+	}
+
+	resetting = 0;
+
+	PT_END(pt);
+}
+
+void oled_Service(void) {
+	if (oled_Drain()) {
+		return;
+	}
+	if (resetting) {
+		oled_ResetThread(&reset_pt);
+	}
+}
+
+void oled_config(void (*kick)(void)) {
+
+// Don't forget to enable GPIOB clock in RCC
+// Don't forget to configure PB13/PB15 as AF0
+// Don't forget to enable SPI2 clock in RCC
+
+	RCC->AHBENR |= RCC_AHBENR_GPIOBEN; //  0x00040000 0b ... 0100 0000 0000 0000 0000, bit 18, RCC_AHBENR[18] = 1
+	RCC->APB1ENR |= RCC_APB1ENR_SPI2EN;	// SPI2 enable
+
+	// step 2, Port B -> AF0 for PB13, PB15
+	GPIOB->MODER |= GPIO_MODER_MODER13_1;
+	GPIOB->MODER |= GPIO_MODER_MODER15_1;
+	GPIOB->AFR[1] = 0;// selecting the 0th alternate function for high end Port B pins
+	GPIOB->MODER |= GPIO_MODER_MODER8_0;	// out
+	GPIOB->MODER |= GPIO_MODER_MODER9_0;	// out
+	GPIOB->MODER |= GPIO_MODER_MODER11_0;	// out
+
+	GPIOB->OTYPER &= ~(GPIO_OTYPER_OT_8 | GPIO_OTYPER_OT_9 | GPIO_OTYPER_OT_11); //set GPIOs outputs as push pull CS, D/C, RES
+	GPIOB->OSPEEDR &= ~(GPIO_OSPEEDR_OSPEEDR13 | GPIO_OSPEEDR_OSPEEDR15
+			| GPIO_OSPEEDR_OSPEEDR8 | //Set SPI bus to slow
+			GPIO_OSPEEDR_OSPEEDR9 | GPIO_OSPEEDR_OSPEEDR11);
+	// SCK/MOSI at medium speed for the 3 MHz bus clock
+	GPIOB->OSPEEDR |= GPIO_OSPEEDR_OSPEEDR13_0 | GPIO_OSPEEDR_OSPEEDR15_0;
+
+	SPI_Handle.Instance = SPI2;
+
+	SPI_Handle.Init.Direction = SPI_DIRECTION_1LINE;
+	SPI_Handle.Init.Mode = SPI_MODE_MASTER;
+	SPI_Handle.Init.DataSize = SPI_DATASIZE_8BIT;
+	SPI_Handle.Init.CLKPolarity = SPI_POLARITY_LOW;
+	SPI_Handle.Init.CLKPhase = SPI_PHASE_1EDGE;
+	SPI_Handle.Init.NSS = SPI_NSS_SOFT;
+	SPI_Handle.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16; // 3 MHz, within the panel's 4 MHz limit
+	SPI_Handle.Init.FirstBit = SPI_FIRSTBIT_MSB;
+	SPI_Handle.Init.CRCPolynomial = 7;
+
+//
+// Initialize the SPI interface
+//
+	HAL_SPI_Init(&SPI_Handle);
+
+//
+// Enable the SPI
+//
+	__HAL_SPI_ENABLE(&SPI_Handle);
+
+//
+// DMA1 channel 5 = SPI2_TX: memory -> SPI2_DR, 8 bit, interrupt at end
+//
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+	DMA1_Channel5->CCR = 0;
+	DMA1_Channel5->CPAR = (uint32_t) &SPI2->DR;
+	DMA1_Channel5->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE;
+	NVIC_EnableIRQ(DMA1_Channel4_5_IRQn);
+
+	/* Reset LED Display (RES# = PB11):
+	 - make pin PB11 = 0, wait for a few ms
+	 - make pin PB11 = 1, wait for a few ms
+	 The waits and the panel init run in oled_ResetThread(); oled_Busy()
+	 stays set until the panel has been initialised.
+	 */
+	GPIOB->BSRR |= GPIO_BSRR_BR_11; 	//make pin PB11 = 0, wait for a few ms
+	oled_kick = kick;
+	resetting = 1;
+	PT_INIT(&reset_pt);
+	swtimer_Setup(&reset_timer, oled_Wake, 0);
+	oled_Service();
+
+}
+
+//
+// DMA transfer path: one CS#/D/C# setup per run instead of per byte
+//
+
+void oled_SetDoneCallback(oled_DoneCallback cb) {
+	dmaDone = cb;
+}
+
+uint8_t oled_Busy(void) {
+	return dmaBusy || resetting;
+}
+
+// minc = DMA_CCR_MINC to send buf, 0 to send buf[0] len times
+static int oled_StartRun(uint8_t dc, const uint8_t *buf, uint16_t len,
+		uint32_t minc) {
+
+	if (dmaBusy || len == 0) {
+		return -1;
+	}
+	dmaBusy = 1;
+
+	// CS# = 1, D/C# for the whole run, CS# = 0
+	GPIOB->BSRR = GPIO_BSRR_BS_8;
+	GPIOB->BSRR = (dc == OLED_DATA) ? GPIO_BSRR_BS_9 : GPIO_BSRR_BR_9;
+	GPIOB->BSRR = GPIO_BSRR_BR_8;
+
+	// 1-line transmit direction (HAL_SPI_Transmit does the same per byte)
+	SPI2->CR1 |= SPI_CR1_BIDIOE;
+	SPI2->CR2 |= SPI_CR2_TXDMAEN;
+
+	DMA1_Channel5->CCR = DMA_CCR_DIR | DMA_CCR_TCIE | minc;
+	DMA1_Channel5->CMAR = (uint32_t) buf;
+	DMA1_Channel5->CNDTR = len;
+	DMA1_Channel5->CCR |= DMA_CCR_EN;
+
+	return 0;
+}
+
+int oled_WriteRun(uint8_t dc, const uint8_t *buf, uint16_t len) {
+	return oled_StartRun(dc, buf, len, DMA_CCR_MINC);
+}
+
+void DMA1_Channel4_5_IRQHandler(void) {
+	IRQ_ENTER();
+
+	if ((DMA1->ISR & DMA_ISR_TCIF5) != 0) {
+		DMA1->IFCR = DMA_IFCR_CTCIF5;
+		DMA1_Channel5->CCR &= ~DMA_CCR_EN;
+
+		// The last bytes are still on the bus: oled_Service() releases CS#
+		draining = 1;
+		oled_Wake(0);
+	}
+
+	IRQ_EXIT(IRQ_ID_DMA_SPI);
+}
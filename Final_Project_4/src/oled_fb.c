@@ -0,0 +1,154 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// RAM framebuffer for the 128x64 OLED with dirty-span tracking.
+// ----------------------------------------------------------------------------
+
+#include "oled_fb.h"
+#include "font.h"
+
+static uint8_t fb[OLED_PAGES][OLED_WIDTH];
+
+// Dirty column span [dirty_lo, dirty_end) per page; dirty_end == 0 means
+// the page is clean, so the zeroed buffer and the cleared GDDRAM agree at
+// reset without any initialisation.
+static uint8_t dirty_lo[OLED_PAGES];
+static uint8_t dirty_end[OLED_PAGES];
+
+static inline void fb_MarkDirty(uint8_t page, uint8_t col) {
+	if (dirty_end[page] == 0) {
+		dirty_lo[page] = col;
+		dirty_end[page] = col + 1;
+	} else if (col < dirty_lo[page]) {
+		dirty_lo[page] = col;
+	} else if (col >= dirty_end[page]) {
+		dirty_end[page] = col + 1;
+	}
+}
+
+void fb_Clear(void) {
+	for (uint8_t page = 0; page < OLED_PAGES; page++) {
+		for (uint8_t col = 0; col < OLED_WIDTH; col++) {
+			fb_Write(page, col, 0x00);
+		}
+	}
+}
+
+void fb_Invalidate(void) {
+	for (uint8_t page = 0; page < OLED_PAGES; page++) {
+		dirty_lo[page] = 0;
+		dirty_end[page] = OLED_WIDTH;
+	}
+}
+
+void fb_Write(uint8_t page, uint8_t col, uint8_t bits) {
+	if (page >= OLED_PAGES || col >= OLED_WIDTH) {
+		return;
+	}
+	if (fb[page][col] != bits) {
+		fb[page][col] = bits;
+		fb_MarkDirty(page, col);
+	}
+}
+
+uint8_t fb_Read(uint8_t page, uint8_t col) {
+	if (page >= OLED_PAGES || col >= OLED_WIDTH) {
+		return 0;
+	}
+	return fb[page][col];
+}
+
+void fb_DrawChar(uint8_t page, uint8_t col, unsigned char c) {
+	const font_Font *font = &font_5x7;
+	const uint8_t *glyph = font_Glyph(font, c);
+	uint8_t k;
+
+	for (k = 0; k < font->width; k++) {
+		fb_Write(page, col + k, glyph[k]);
+	}
+	// Inter-character gap is not stored in flash
+	for (; k < font_Advance(font); k++) {
+		fb_Write(page, col + k, 0x00);
+	}
+}
+
+void fb_DrawString(uint8_t page, uint8_t col, const unsigned char *s) {
+	uint8_t advance = font_Advance(&font_5x7);
+	uint8_t x = col;
+	for (uint8_t i = 0; s[i] != '\0' && x <= OLED_WIDTH - advance; i++) {
+		fb_DrawChar(page, x, s[i]);
+		x += advance;
+	}
+}
+
+// Spans captured by fb_Flush() and replayed by the run completion chain
+// (oled_Service()), so drawing can go on into dirty_* meanwhile.
+static uint8_t flush_lo[OLED_PAGES];
+static uint8_t flush_end[OLED_PAGES];
+static uint8_t flush_cmd[3];
+static volatile uint8_t flush_page;
+static volatile uint8_t flush_data_next;
+static volatile uint8_t flush_busy = 0;
+
+// Run completion: command run -> data run -> next page's command run
+static void fb_FlushNext(void) {
+	uint8_t page = flush_page;
+
+	if (flush_data_next) {
+		flush_data_next = 0;
+		flush_page = page + 1;
+		oled_WriteRun(OLED_DATA, &fb[page][flush_lo[page]],
+				flush_end[page] - flush_lo[page]);
+		return;
+	}
+
+	while (page < OLED_PAGES && flush_end[page] == 0) {
+		page++;
+	}
+	if (page >= OLED_PAGES) {
+		flush_busy = 0;
+		return;
+	}
+
+	uint8_t col = flush_lo[page] + OLED_COL_OFFSET;
+	flush_cmd[0] = 0xB0 | (page & 0x07);		// page address
+	flush_cmd[1] = 0x00 | (col & 0x0F);			// column, lower nibble
+	flush_cmd[2] = 0x10 | ((col >> 4) & 0x0F);	// column, upper nibble
+
+	flush_page = page;
+	flush_data_next = 1;
+	oled_WriteRun(OLED_CMD, flush_cmd, sizeof(flush_cmd));
+}
+
+uint8_t fb_FlushBusy(void) {
+	return flush_busy;
+}
+
+uint16_t fb_Flush(void) {
+	uint16_t sent = 0;
+
+	if (flush_busy || oled_Busy()) {
+		return 0;
+	}
+
+	for (uint8_t page = 0; page < OLED_PAGES; page++) {
+		flush_lo[page] = dirty_lo[page];
+		flush_end[page] = dirty_end[page];
+		dirty_end[page] = 0;
+
+		if (flush_end[page] != 0) {
+			// Page address + two column nibbles, then the span itself
+			sent += sizeof(flush_cmd) + (flush_end[page] - flush_lo[page]);
+		}
+	}
+
+	if (sent != 0) {
+		flush_busy = 1;
+		flush_page = 0;
+		flush_data_next = 0;
+		oled_SetDoneCallback(fb_FlushNext);
+		fb_FlushNext();
+	}
+
+	return sent;
+}
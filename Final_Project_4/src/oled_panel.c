@@ -0,0 +1,45 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// OLED controller command sequences.
+//
+// Kept apart from the SPI/GPIO code in oled.c: the firmware's reset thread
+// and the host emulator (tools/oled_emu) both walk oled_InitStep(), so the
+// emulator replays exactly the frames the firmware sends.
+// ----------------------------------------------------------------------------
+
+#include "oled.h"
+
+//
+// LED Display initialization commands
+//
+static const uint8_t oled_init_cmds[] = { 0xAE, 0x20, 0x00, 0x40, 0xA0 | 0x01,
+		0xA8, 0x40 - 1, 0xC0 | 0x08, 0xD3, 0x00, 0xDA, 0x32, 0xD5, 0x80, 0xD9,
+		0x22, 0xDB, 0x30, 0x81, 0xFF, 0xA4, 0xA6, 0xAD, 0x30, 0x8D, 0x10,
+		0xAE | 0x01, 0xC0, 0xA0 };
+static const uint8_t zero = 0;
+static uint8_t page_cmd[3];
+
+uint8_t oled_InitStep(uint8_t step, oled_Run *run) {
+	if (step == 0) {
+		*run = (oled_Run) { oled_init_cmds, sizeof(oled_init_cmds),
+				OLED_CMD, 0 };
+		return 1;
+	}
+
+	// Fill LED Display data memory (GDDRAM) with zeros: for each page the
+	// page and start column, then one zero byte per column
+	uint8_t page = (uint8_t) ((step - 1) >> 1);
+	if (page >= OLED_PAGES) {
+		return 0;
+	}
+	if (((step - 1) & 1) == 0) {
+		page_cmd[0] = 0xB0 | page;
+		page_cmd[1] = 0x00 | (OLED_COL_OFFSET & 0x0F);
+		page_cmd[2] = 0x10 | ((OLED_COL_OFFSET >> 4) & 0x0F);
+		*run = (oled_Run) { page_cmd, sizeof(page_cmd), OLED_CMD, 0 };
+	} else {
+		*run = (oled_Run) { &zero, OLED_WIDTH, OLED_DATA, 1 };
+	}
+	return 1;
+}
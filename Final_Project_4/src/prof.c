@@ -0,0 +1,135 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Cycle profiler for hot code zones.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "stm32f0xx_hal.h"
+#include "diag/Trace.h"
+#include "prof.h"
+#include "timer.h"
+
+//
+// SysTick as a free-running cycle counter instead of the HAL 1 ms tick
+//
+
+// Called by HAL_Init() (and the HAL clock code). Nothing in this firmware
+// increments the HAL tick, so its interrupt only cost a wakeup every
+// reload; SysTick counts core cycles instead.
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority) {
+	(void) TickPriority;
+
+	SysTick->CTRL = 0;
+	SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+	return HAL_OK;
+}
+
+// HAL timeouts run on the TIM3 millisecond timebase
+uint32_t HAL_GetTick(void) {
+	return timer_Now();
+}
+
+#ifdef PROF_ENABLE
+
+static const char *const prof_names[PROF_COUNT] = {
+	[PROF_ID_CAPTURE] = "capture",
+	[PROF_ID_FREQ] = "freq",
+	[PROF_ID_TIMERS] = "timers",
+	[PROF_ID_IO] = "io",
+	[PROF_ID_RENDER] = "render",
+	[PROF_ID_FLUSH] = "flush",
+	[PROF_ID_SWEEP_BLOCK] = "sweep_blk",
+	[PROF_ID_FMT] = "fmt",
+	[PROF_ID_SNPRINTF] = "snprintf",
+};
+
+prof_Zone prof_zones[PROF_COUNT];
+static uint32_t overhead = 0;	// cycles an empty zone reports
+
+void prof_Reset(void) {
+	for (uint8_t i = 0; i < PROF_COUNT; i++) {
+		prof_zones[i] = (prof_Zone) { 0 };
+		prof_zones[i].min = UINT32_MAX;
+	}
+}
+
+void prof_Init(void) {
+	uint32_t primask = __get_PRIMASK();
+
+	prof_Reset();
+
+	// The smallest of a few empty zones, undisturbed by interrupts
+	__disable_irq();
+	for (uint8_t i = 0; i < 8; i++) {
+		PROF_BEGIN(PROF_ID_CAPTURE);
+		PROF_END(PROF_ID_CAPTURE);
+	}
+	__set_PRIMASK(primask);
+	overhead = prof_zones[PROF_ID_CAPTURE].min;
+
+	prof_Reset();
+}
+
+static uint32_t prof_Net(uint32_t cycles) {
+	return cycles > overhead ? cycles - overhead : 0;
+}
+
+void prof_Report(void) {
+	uint8_t order[PROF_COUNT];
+	uint32_t per_us = SystemCoreClock / 1000000;
+
+	// Hottest (largest total) first; a handful of zones, insertion sort
+	for (uint8_t i = 0; i < PROF_COUNT; i++) {
+		uint8_t j = i;
+
+		while (j > 0
+				&& prof_zones[order[j - 1]].total < prof_zones[i].total) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	trace_printf("prof: cycles, overhead %u removed\n", (unsigned) overhead);
+	for (uint8_t k = 0; k < PROF_COUNT; k++) {
+		const prof_Zone *z = &prof_zones[order[k]];
+
+		if (z->count == 0) {
+			continue;
+		}
+		uint32_t net = z->total - overhead * z->count;
+		if (net > z->total) {
+			net = 0;
+		}
+		trace_printf("%-9s n=%u min=%u avg=%u max=%u total=%uus\n",
+				prof_names[order[k]], (unsigned) z->count,
+				(unsigned) prof_Net(z->min),
+				(unsigned) (net / z->count), (unsigned) prof_Net(z->max),
+				(unsigned) (net / per_us));
+#ifdef PROF_HIST
+		trace_printf("          log2:");
+		for (uint8_t b = 0; b < PROF_BUCKETS; b++) {
+			if (z->hist[b] != 0) {
+				trace_printf(" %u:%u", (unsigned) b, (unsigned) z->hist[b]);
+			}
+		}
+		trace_printf("\n");
+#endif
+	}
+}
+
+#else
+
+void prof_Init(void) {
+}
+
+void prof_Report(void) {
+}
+
+void prof_Reset(void) {
+}
+
+#endif // PROF_ENABLE
@@ -0,0 +1,161 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Lock-free single-producer / single-consumer ring buffers.
+// ----------------------------------------------------------------------------
+
+#include <string.h>
+#include "cmsis/cmsis_device.h"
+#include "ring.h"
+
+// Each side reads the other's index once, copies the data, and only then
+// publishes its own index; the barriers keep the data accesses on the
+// right side of that store.
+
+int ring_Init(ring_Ring *r, void *buf, uint16_t size, uint32_t count) {
+	if (count == 0 || (count & (count - 1)) != 0) {
+		return -1;
+	}
+	r->buf = buf;
+	r->mask = count - 1;
+	r->size = size;
+	r->head = 0;
+	r->tail = 0;
+	r->dropped = 0;
+	return 0;
+}
+
+uint32_t ring_Count(const ring_Ring *r) {
+	return r->head - r->tail;
+}
+
+uint32_t ring_Free(const ring_Ring *r) {
+	return r->mask + 1 - (r->head - r->tail);
+}
+
+static inline uint8_t* ring_Slot(const ring_Ring *r, uint32_t index) {
+	return r->buf + (index & r->mask) * r->size;
+}
+
+// Copy n elements to/from the ring starting at index, in at most two parts
+static void ring_CopyIn(ring_Ring *r, uint32_t index, const uint8_t *src,
+		uint32_t n) {
+	uint32_t first = r->mask + 1 - (index & r->mask);
+
+	if (first > n) {
+		first = n;
+	}
+	memcpy(ring_Slot(r, index), src, first * r->size);
+	memcpy(r->buf, src + first * r->size, (n - first) * r->size);
+}
+
+static void ring_CopyOut(const ring_Ring *r, uint32_t index, uint8_t *dst,
+		uint32_t n) {
+	uint32_t first = r->mask + 1 - (index & r->mask);
+
+	if (first > n) {
+		first = n;
+	}
+	memcpy(dst, ring_Slot(r, index), first * r->size);
+	memcpy(dst + first * r->size, r->buf, (n - first) * r->size);
+}
+
+int ring_Push(ring_Ring *r, const void *item) {
+	uint32_t head = r->head;
+
+	if (head - r->tail > r->mask) {
+		r->dropped++;
+		return -1;
+	}
+	__DMB();	// the slot may have just been freed by the consumer
+	memcpy(ring_Slot(r, head), item, r->size);
+	__DMB();
+	r->head = head + 1;
+	return 0;
+}
+
+uint32_t ring_PushBulk(ring_Ring *r, const void *items, uint32_t n) {
+	uint32_t head = r->head;
+	uint32_t space = r->mask + 1 - (head - r->tail);
+
+	if (n > space) {
+		r->dropped += n - space;
+		n = space;
+	}
+	if (n != 0) {
+		__DMB();
+		ring_CopyIn(r, head, items, n);
+		__DMB();
+		r->head = head + n;
+	}
+	return n;
+}
+
+void* ring_Reserve(ring_Ring *r, uint32_t *n) {
+	uint32_t head = r->head;
+	uint32_t space = r->mask + 1 - (head - r->tail);
+	uint32_t contiguous = r->mask + 1 - (head & r->mask);
+
+	if (space > contiguous) {
+		space = contiguous;
+	}
+	if (*n > space) {
+		*n = space;
+	}
+	__DMB();
+	return ring_Slot(r, head);
+}
+
+void ring_Commit(ring_Ring *r, uint32_t n) {
+	__DMB();
+	r->head += n;
+}
+
+int ring_Pop(ring_Ring *r, void *item) {
+	uint32_t tail = r->tail;
+
+	if (r->head == tail) {
+		return -1;
+	}
+	__DMB();	// read the element only after seeing the new head
+	memcpy(item, ring_Slot(r, tail), r->size);
+	__DMB();
+	r->tail = tail + 1;
+	return 0;
+}
+
+uint32_t ring_PopBulk(ring_Ring *r, void *items, uint32_t n) {
+	uint32_t tail = r->tail;
+	uint32_t count = r->head - tail;
+
+	if (n > count) {
+		n = count;
+	}
+	if (n != 0) {
+		__DMB();
+		ring_CopyOut(r, tail, items, n);
+		__DMB();
+		r->tail = tail + n;
+	}
+	return n;
+}
+
+const void* ring_Peek(ring_Ring *r, uint32_t *n) {
+	uint32_t tail = r->tail;
+	uint32_t count = r->head - tail;
+	uint32_t contiguous = r->mask + 1 - (tail & r->mask);
+
+	if (count > contiguous) {
+		count = contiguous;
+	}
+	if (*n > count) {
+		*n = count;
+	}
+	__DMB();
+	return ring_Slot(r, tail);
+}
+
+void ring_Release(ring_Ring *r, uint32_t n) {
+	__DMB();
+	r->tail += n;
+}
@@ -0,0 +1,164 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Cooperative run-to-completion scheduler.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "sched.h"
+#include "timer.h"
+#include "metrics.h"
+
+#define SCHED_RECORD	5		// sched_Stats fields in the metrics record
+
+static const sched_Task *tasks = 0;
+static uint8_t task_count = 0;
+static sched_Stats stats[SCHED_MAX_TASKS];
+static void (*idle_hook)(void) = 0;
+static volatile uint32_t posted = 0;
+
+// One record per task, named after the task table
+static metrics_Metric sched_metrics[SCHED_MAX_TASKS];
+static metrics_Group sched_group = { "sched", sched_metrics, 0, 0 };
+
+void sched_Init(const sched_Task *table, uint8_t count) {
+	uint32_t now = timer_Now();
+
+	if (count > SCHED_MAX_TASKS) {
+		count = SCHED_MAX_TASKS;
+	}
+	tasks = table;
+	task_count = count;
+	for (uint8_t i = 0; i < count; i++) {
+		stats[i] = (sched_Stats) { 0 };
+		stats[i].next_release = now + tasks[i].period_ms;
+		sched_metrics[i].name = tasks[i].name;
+		sched_metrics[i].kind = METRICS_RECORD;
+		sched_metrics[i].buckets = SCHED_RECORD;
+		sched_metrics[i].value = &stats[i].runs;
+	}
+	sched_group.count = count;
+	metrics_Register(&sched_group);
+}
+
+void sched_SetIdleHook(void (*idle)(void)) {
+	idle_hook = idle;
+}
+
+void sched_Post(uint32_t events) {
+	// No LDREX/STREX on the M0: mask interrupts around the read-modify-write
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	posted |= events;
+	__set_PRIMASK(primask);
+}
+
+static uint32_t sched_TakeEvents(void) {
+	uint32_t events;
+
+	__disable_irq();
+	events = posted;
+	posted = 0;
+	__enable_irq();
+	return events;
+}
+
+// Mark tasks released by elapsed periods or the events just taken
+static void sched_Release(uint32_t now, uint32_t events) {
+	for (uint8_t i = 0; i < task_count; i++) {
+		sched_Stats *s = &stats[i];
+
+		if (s->released) {
+			continue;
+		}
+		if ((tasks[i].events & events) != 0) {
+			s->released = 1;
+			s->released_at = now;
+		} else if (tasks[i].period_ms != 0
+				&& (int32_t) (now - s->next_release) >= 0) {
+			s->released = 1;
+			s->released_at = s->next_release;
+		}
+	}
+}
+
+static void sched_Execute(uint8_t i) {
+	const sched_Task *t = &tasks[i];
+	sched_Stats *s = &stats[i];
+	uint32_t start = timer_Micros();
+
+	t->run();
+
+	uint32_t exec = timer_Micros() - start;
+	uint32_t end = timer_Now();
+	uint32_t late = end - s->released_at;
+
+	s->released = 0;
+	s->runs++;
+	s->exec_total_us += exec;
+	if (exec > s->exec_max_us) {
+		s->exec_max_us = exec;
+	}
+	if (late > s->late_max_ms) {
+		s->late_max_ms = late;
+	}
+	if (t->deadline_ms != 0 && late > t->deadline_ms) {
+		s->misses++;
+	}
+
+	if (t->period_ms != 0) {
+		s->next_release += t->period_ms;
+		if ((int32_t) (end - s->next_release) >= 0) {
+			// Overran a whole period; skip the lost releases
+			s->next_release = end + t->period_ms;
+		}
+	}
+}
+
+uint16_t sched_NextDue(void) {
+	uint32_t now = timer_Now();
+	uint32_t soonest = 0xFFFF;
+
+	if (posted != 0) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < task_count; i++) {
+		if (stats[i].released) {
+			return 0;
+		}
+		if (tasks[i].period_ms != 0) {
+			int32_t wait = (int32_t) (stats[i].next_release - now);
+			if (wait <= 0) {
+				return 0;
+			}
+			if ((uint32_t) wait < soonest) {
+				soonest = (uint32_t) wait;
+			}
+		}
+	}
+	return (uint16_t) soonest;
+}
+
+void sched_Run(void) {
+	while (1) {
+		uint32_t now = timer_Now();
+		uint8_t i;
+
+		sched_Release(now, sched_TakeEvents());
+
+		// Highest-priority released task, then rescan
+		for (i = 0; i < task_count; i++) {
+			if (stats[i].released) {
+				sched_Execute(i);
+				break;
+			}
+		}
+		if (i == task_count && idle_hook) {
+			idle_hook();
+		}
+	}
+}
+
+const sched_Stats* sched_GetStats(uint8_t task) {
+	return task < task_count ? &stats[task] : 0;
+}
@@ -0,0 +1,380 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Frequency sweep generator with synchronized response measurement.
+//
+// Everything after sweep_Start() runs from interrupts:
+//   TIM15 one-pulse (settle_ms)  ->  TIM15 ISR arms the ADC block
+//   TIM15 TRGO at 32 x f         ->  ADC1 samples PA5 into sweep_Block (DMA1 ch1)
+//   DMA1 ch1 transfer complete   ->  stop the block, post to PendSV
+//   PendSV (defer.h)             ->  amplitude, store point, step frequency
+//
+// See "system/include/cmsis/stm32f051x8.h" for register/bit definitions.
+// ----------------------------------------------------------------------------
+
+#include <math.h>
+#include "cmsis/cmsis_device.h"
+#include "sweep.h"
+#include "irq.h"
+#include "prof.h"
+#include "evtrace.h"
+#include "defer.h"
+
+#define SWEEP_TABLE_LEN		32		// DAC/ADC samples per output period
+#define SWEEP_TABLE_AMP		2000	// peak amplitude of the table (DAC counts)
+#define SWEEP_BLOCK_LEN		64		// ADC samples per point = 2 periods
+
+// 2048 + 2000 * sin(2 * pi * n / 32); sums to exactly 32 * 2048 so the DC
+// term drops out of the correlation below.
+static const uint16_t sweep_Sine[SWEEP_TABLE_LEN] = { 2048, 2438, 2813, 3159,
+		3462, 3711, 3896, 4010, 4048, 4010, 3896, 3711, 3462, 3159, 2813, 2438,
+		2048, 1658, 1283, 937, 634, 385, 200, 86, 48, 86, 200, 385, 634, 937,
+		1283, 1658 };
+
+typedef enum {
+	SWEEP_IDLE = 0, SWEEP_SETTLING, SWEEP_ACQUIRING, SWEEP_COMPUTING
+} sweep_State;
+
+static volatile sweep_State state = SWEEP_IDLE;
+static volatile uint16_t count = 0;
+static sweep_Point results[SWEEP_MAX_POINTS];
+static uint16_t block[SWEEP_BLOCK_LEN];
+
+// Current sweep parameters
+static uint16_t points;
+static uint16_t settle_ms;
+static sweep_Scale scale;
+static uint32_t f_start;
+static uint32_t f_stop;
+static float f_log;			// running frequency for the log schedule
+static float f_log_step;	// per-point ratio for the log schedule
+
+// Output timing shared by TIM6 (DAC) and TIM15 (ADC)
+static uint16_t rate_psc;
+static uint16_t rate_arr;
+static uint32_t f_actual;
+
+// ADC configuration of the main loop, restored when the sweep ends
+static uint32_t adc_cfgr1;
+static uint32_t adc_chselr;
+static uint32_t adc_smpr;
+
+// Block processing, posted by the DMA ISR
+DEFER_QUEUE(sweep_work, 2);
+
+static void sweep_SetFreq(uint32_t f);
+static void sweep_Settle(void);
+static void sweep_StartBlock(void);
+static uint16_t sweep_Amplitude(void);
+static void sweep_Release(void);
+
+void sweep_Init(void) {
+
+	RCC->AHBENR |= RCC_AHBENR_GPIOAEN | RCC_AHBENR_DMA1EN;
+	RCC->APB1ENR |= RCC_APB1ENR_TIM6EN | RCC_APB1ENR_DACEN;
+	RCC->APB2ENR |= RCC_APB2ENR_TIM15EN;
+
+	// PA5 = ADC_IN5, response of the device under test
+	GPIOA->MODER |= GPIO_MODER_MODER5;
+
+	// TIM6 and TIM15: update event -> TRGO
+	TIM6->CR2 = TIM_CR2_MMS_1;
+	TIM15->CR2 = TIM_CR2_MMS_1;
+
+	// DMA1 channel 3: sine table -> DAC_DHR12R1, 16 bit, circular
+	DMA1_Channel3->CCR = 0;
+	DMA1_Channel3->CPAR = (uint32_t) &DAC->DHR12R1;
+	DMA1_Channel3->CMAR = (uint32_t) sweep_Sine;
+	DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_DIR
+			| DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0;
+
+	// DMA1 channel 1: ADC1_DR -> block, 16 bit, one shot, interrupt at end
+	DMA1_Channel1->CCR = 0;
+	DMA1_Channel1->CPAR = (uint32_t) &ADC1->DR;
+	DMA1_Channel1->CMAR = (uint32_t) block;
+	DMA1_Channel1->CCR = DMA_CCR_MINC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0
+			| DMA_CCR_TCIE;
+
+	defer_Register(&sweep_work);
+
+	NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+	NVIC_EnableIRQ(TIM15_IRQn);
+}
+
+int sweep_Start(uint32_t start, uint32_t stop, uint16_t n, sweep_Scale sc,
+		uint16_t settle) {
+
+	if (state != SWEEP_IDLE || n < 2 || n > SWEEP_MAX_POINTS
+			|| start < SWEEP_MIN_FREQ || start > SWEEP_MAX_FREQ
+			|| stop < SWEEP_MIN_FREQ || stop > SWEEP_MAX_FREQ) {
+		return -1;
+	}
+
+	f_start = start;
+	f_stop = stop;
+	points = n;
+	scale = sc;
+	settle_ms = (settle != 0) ? settle : 1;
+	count = 0;
+
+	if (scale == SWEEP_LOG) {
+		// One powf per sweep; each point is then a single multiply
+		f_log = (float) start;
+		f_log_step = powf((float) stop / (float) start, 1.0f / (float) (n - 1));
+	}
+
+	// Take the ADC away from the main loop for the whole sweep
+	ADC1->CR |= ADC_CR_ADSTP;
+	while (ADC1->CR & ADC_CR_ADSTART) {
+	}
+	adc_cfgr1 = ADC1->CFGR1;
+	adc_chselr = ADC1->CHSELR;
+	adc_smpr = ADC1->SMPR;
+
+	// DAC1: triggered by TIM6 TRGO (TSEL1 = 000), fed by DMA1 channel 3.
+	// TSEL1 can only be changed while the channel is disabled.
+	DAC->CR &= ~DAC_CR_EN1;
+	DAC->CR = (DAC->CR & ~DAC_CR_TSEL1) | DAC_CR_TEN1 | DAC_CR_DMAEN1;
+	DAC->CR |= DAC_CR_EN1;
+
+	state = SWEEP_SETTLING;
+	evtrace_Event(EVTRACE_SWEEP, 1, n);
+	sweep_SetFreq(f_start);
+	DMA1_Channel3->CNDTR = SWEEP_TABLE_LEN;
+	DMA1_Channel3->CCR |= DMA_CCR_EN;
+	sweep_Settle();
+
+	return 0;
+}
+
+// Masked throughout: a block posted to PendSV must not restart the timers
+// halfway through the release. The ADSTP wait is a few ADC cycles.
+void sweep_Stop(void) {
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (state != SWEEP_IDLE) {
+		sweep_Release();
+	}
+	__set_PRIMASK(primask);
+}
+
+uint8_t sweep_IsRunning(void) {
+	return state != SWEEP_IDLE;
+}
+
+uint16_t sweep_Count(void) {
+	return count;
+}
+
+uint16_t sweep_Points(void) {
+	return points;
+}
+
+const sweep_Point* sweep_Results(void) {
+	return results;
+}
+
+// Program TIM6 for SWEEP_TABLE_LEN DAC updates per output period
+static void sweep_SetFreq(uint32_t f) {
+
+	uint32_t ticks = SystemCoreClock / (SWEEP_TABLE_LEN * f);
+	uint32_t psc = (ticks - 1) >> 16;
+
+	rate_psc = (uint16_t) psc;
+	rate_arr = (uint16_t) (ticks / (psc + 1) - 1);
+	f_actual = SystemCoreClock
+			/ (SWEEP_TABLE_LEN * (psc + 1) * ((uint32_t) rate_arr + 1));
+
+	TIM6->CR1 &= ~TIM_CR1_CEN;
+	TIM6->PSC = rate_psc;
+	TIM6->ARR = rate_arr;
+	TIM6->EGR = TIM_EGR_UG;
+	TIM6->CR1 |= TIM_CR1_CEN;
+}
+
+// TIM15 as a one-pulse millisecond timer for the settling delay
+static void sweep_Settle(void) {
+
+	TIM15->CR1 = TIM_CR1_OPM;
+	TIM15->DIER = 0;
+	TIM15->PSC = (SystemCoreClock / 1000) - 1;
+	TIM15->ARR = settle_ms;
+	TIM15->EGR = TIM_EGR_UG;
+	TIM15->SR = 0;
+	TIM15->DIER = TIM_DIER_UIE;
+	TIM15->CR1 |= TIM_CR1_CEN;
+}
+
+// Retime TIM15 to the DAC rate and let its TRGO pace one ADC block
+static void sweep_StartBlock(void) {
+
+	TIM15->CR1 = 0;
+	TIM15->DIER = 0;
+	TIM15->PSC = rate_psc;
+	TIM15->ARR = rate_arr;
+	TIM15->EGR = TIM_EGR_UG;
+	TIM15->SR = 0;
+
+	// ADC1: single conversions on rising TIM15_TRGO (EXTSEL = 100), DMA one
+	// shot, PA5 only, 7.5 cycle sampling to keep up with 640 kSPS
+	while (ADC1->CR & ADC_CR_ADSTART) {
+	}
+	ADC1->CFGR1 = (adc_cfgr1
+			& ~(ADC_CFGR1_CONT | ADC_CFGR1_EXTSEL | ADC_CFGR1_EXTEN
+					| ADC_CFGR1_DMACFG)) | ADC_CFGR1_EXTEN_0
+			| ADC_CFGR1_EXTSEL_2 | ADC_CFGR1_DMAEN;
+	ADC1->CHSELR = ADC_CHSELR_CHSEL5;
+	ADC1->SMPR = ADC_SMPR_SMP_0;
+
+	DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+	DMA1_Channel1->CNDTR = SWEEP_BLOCK_LEN;
+	DMA1_Channel1->CCR |= DMA_CCR_EN;
+
+	ADC1->ISR = ADC_ISR_OVR | ADC_ISR_EOC | ADC_ISR_EOSEQ;
+	ADC1->CR |= ADC_CR_ADSTART;
+
+	state = SWEEP_ACQUIRING;
+	TIM15->CR1 = TIM_CR1_CEN;
+}
+
+static uint32_t sweep_Isqrt(uint64_t x) {
+	uint64_t res = 0;
+	uint64_t bit = (uint64_t) 1 << 62;
+
+	while (bit > x) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (x >= res + bit) {
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t) res;
+}
+
+// Single-bin DFT at the output frequency. The block covers exactly two
+// periods, so correlating against the DAC table (and its quarter-period
+// shift) gives the in-phase/quadrature parts with no windowing error.
+static uint16_t sweep_Amplitude(void) {
+	int32_t i_acc = 0;
+	int32_t q_acc = 0;
+
+	for (uint16_t n = 0; n < SWEEP_BLOCK_LEN; n++) {
+		int32_t x = block[n];
+		i_acc += x * ((int32_t) sweep_Sine[n & (SWEEP_TABLE_LEN - 1)] - 2048);
+		q_acc += x
+				* ((int32_t) sweep_Sine[(n + SWEEP_TABLE_LEN / 4)
+						& (SWEEP_TABLE_LEN - 1)] - 2048);
+	}
+
+	uint32_t mag = sweep_Isqrt(
+			(uint64_t) ((int64_t) i_acc * i_acc)
+					+ (uint64_t) ((int64_t) q_acc * q_acc));
+
+	// |z| = A * SWEEP_TABLE_AMP * SWEEP_BLOCK_LEN / 2
+	return (uint16_t) (mag / (SWEEP_TABLE_AMP * SWEEP_BLOCK_LEN / 2));
+}
+
+// Stop all sweep hardware and give the DAC/ADC back to the main loop
+static void sweep_Release(void) {
+
+	TIM15->CR1 = 0;
+	TIM15->DIER = 0;
+	TIM6->CR1 &= ~TIM_CR1_CEN;
+	DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+	DMA1_Channel3->CCR &= ~DMA_CCR_EN;
+
+	DAC->CR &= ~DAC_CR_EN1;
+	DAC->CR &= ~(DAC_CR_TEN1 | DAC_CR_DMAEN1);
+	DAC->CR |= DAC_CR_EN1;
+
+	// adc_Read starts a conversion without checking ADSTART
+	ADC1->CR |= ADC_CR_ADSTP;
+	while (ADC1->CR & ADC_CR_ADSTART) {
+	}
+	ADC1->CFGR1 = adc_cfgr1;
+	ADC1->CHSELR = adc_chselr;
+	ADC1->SMPR = adc_smpr;
+
+	state = SWEEP_IDLE;
+	evtrace_Event(EVTRACE_SWEEP, 0, 0);
+}
+
+void TIM15_IRQHandler(void) {
+	IRQ_ENTER();
+
+	if ((TIM15->SR & TIM_SR_UIF) != 0) {
+		TIM15->SR &= ~TIM_SR_UIF;
+
+		if (state == SWEEP_SETTLING) {
+			sweep_StartBlock();
+		}
+	}
+
+	IRQ_EXIT(IRQ_ID_TIM15);
+}
+
+// Store the point and step to the next frequency
+static void sweep_NextPoint(void) {
+	results[count].freq = f_actual;
+	results[count].amplitude = sweep_Amplitude();
+	count++;
+
+	if (count >= points) {
+		sweep_Release();
+		return;
+	}
+
+	uint32_t f;
+	if (scale == SWEEP_LOG) {
+		f_log *= f_log_step;
+		f = (uint32_t) (f_log + 0.5f);
+	} else {
+		f = f_start
+				+ (uint32_t) (((int32_t) f_stop - (int32_t) f_start)
+						* (int32_t) count / (int32_t) (points - 1));
+	}
+
+	state = SWEEP_SETTLING;
+	sweep_SetFreq(f);
+	sweep_Settle();
+}
+
+// Deferred from the DMA ISR (PendSV)
+static void sweep_BlockDone(uint32_t arg) {
+	(void) arg;
+
+	if (state != SWEEP_COMPUTING) {
+		return;		// stopped meanwhile
+	}
+
+	PROF_BEGIN(PROF_ID_SWEEP_BLOCK);
+	sweep_NextPoint();
+	PROF_END(PROF_ID_SWEEP_BLOCK);
+}
+
+// Block complete: stop the acquisition and leave the arithmetic to PendSV
+void DMA1_Channel1_IRQHandler(void) {
+	IRQ_ENTER();
+
+	if ((DMA1->ISR & DMA_ISR_TCIF1) != 0) {
+		DMA1->IFCR = DMA_IFCR_CTCIF1;
+		TIM15->CR1 = 0;
+		ADC1->CR |= ADC_CR_ADSTP;
+		DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+
+		if (state == SWEEP_ACQUIRING) {
+			state = SWEEP_COMPUTING;
+			if (defer_Post(&sweep_work, sweep_BlockDone, 0) != 0) {
+				sweep_Release();
+			}
+		}
+	}
+
+	IRQ_EXIT(IRQ_ID_DMA_ADC);
+}
@@ -0,0 +1,209 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Software timers on a hierarchical timer wheel.
+// ----------------------------------------------------------------------------
+
+#include "swtimer.h"
+#include "timer.h"
+
+#define WHEEL_BITS		6
+#define WHEEL_SIZE		(1u << WHEEL_BITS)
+#define WHEEL_MASK		(WHEEL_SIZE - 1)
+#define WHEEL_LEVELS	4
+#define WHEEL_SPAN		(1ul << (WHEEL_BITS * WHEEL_LEVELS))	// 2^24 ms
+
+static swtimer_Timer *wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static uint32_t base;		// last ms handled; slots hold times after it
+static uint16_t queued = 0;
+static void (*kick_fn)(void) = 0;
+
+static inline uint8_t swtimer_Index(uint32_t t, uint8_t level) {
+	return (uint8_t) ((t >> (WHEEL_BITS * level)) & WHEEL_MASK);
+}
+
+static void swtimer_Link(swtimer_Timer **head, swtimer_Timer *t) {
+	t->next = *head;
+	if (t->next) {
+		t->next->pprev = &t->next;
+	}
+	t->pprev = head;
+	*head = t;
+}
+
+static void swtimer_Unlink(swtimer_Timer *t) {
+	*t->pprev = t->next;
+	if (t->next) {
+		t->next->pprev = t->pprev;
+	}
+	t->next = 0;
+	t->pprev = 0;
+}
+
+// Slot by distance from base. The inner wheel takes the next WHEEL_SIZE
+// ms after base (base + 64 shares base's slot, which has been handled).
+// Wheel n takes longer delays: its slot covering the expiry time cascades
+// at that slot's start, which is after base, and the timer is re-queued
+// from there. A cascade queues from just before its slot starts, so a
+// timer never goes back into the outer slot being emptied.
+static void swtimer_Queue(swtimer_Timer *t) {
+	uint32_t delta = t->expires - base;
+	uint32_t at = t->expires;
+	uint8_t level = 0;
+
+	if ((int32_t) delta <= 0) {
+		at = base + 1;			// overdue: the next slot handled
+		delta = 0;
+	} else if (delta >= WHEEL_SPAN) {
+		at = base + WHEEL_SPAN - 1;	// re-queued from the outer wheel
+		delta = WHEEL_SPAN - 1;
+	}
+	if (delta > WHEEL_SIZE) {
+		for (level = 1; level < WHEEL_LEVELS - 1; level++) {
+			if (delta < (1ul << (WHEEL_BITS * (level + 1)))) {
+				break;
+			}
+		}
+	}
+	swtimer_Link(&wheel[level][swtimer_Index(at, level)], t);
+}
+
+// Next time after base with work: an occupied inner slot, or the end of
+// the inner wheel's turn, where the outer wheels cascade
+static uint32_t swtimer_NextEvent(void) {
+	uint32_t t = base + 1;
+
+	while (wheel[0][t & WHEEL_MASK] == 0 && (t & WHEEL_MASK) != 0) {
+		t++;
+	}
+	return t;
+}
+
+static void swtimer_Kick(void) {
+	if (kick_fn) {
+		kick_fn();
+	}
+}
+
+static void swtimer_Arm(void) {
+	if (queued == 0) {
+		timer_CancelAlarm();
+		return;
+	}
+	int32_t wait = (int32_t) (swtimer_NextEvent() - timer_Now());
+	timer_SetAlarm(wait > 0 ? (uint32_t) wait : 0, swtimer_Kick);
+}
+
+void swtimer_Init(void (*kick)(void)) {
+	kick_fn = kick;
+	base = timer_Now();
+}
+
+void swtimer_Setup(swtimer_Timer *t, swtimer_Callback callback, void *arg) {
+	t->next = 0;
+	t->pprev = 0;
+	t->callback = callback;
+	t->arg = arg;
+}
+
+void swtimer_Start(swtimer_Timer *t, uint32_t delay_ms, uint32_t period_ms) {
+	uint32_t now = timer_Now();
+
+	swtimer_Stop(t);
+	if (queued == 0) {
+		base = now;				// nothing to turn the wheel for until now
+	}
+	t->expires = now + delay_ms;
+	t->period_ms = period_ms;
+	swtimer_Queue(t);
+	queued++;
+	swtimer_Arm();
+}
+
+void swtimer_Stop(swtimer_Timer *t) {
+	if (t->pprev) {
+		swtimer_Unlink(t);
+		queued--;
+	}
+}
+
+uint8_t swtimer_Pending(const swtimer_Timer *t) {
+	return t->pprev != 0;
+}
+
+// Move every timer in one outer slot to the wheels below it
+static void swtimer_Cascade(uint8_t level, uint8_t index) {
+	swtimer_Timer *t = wheel[level][index];
+
+	wheel[level][index] = 0;
+	while (t) {
+		swtimer_Timer *next = t->next;
+		swtimer_Queue(t);
+		t = next;
+	}
+}
+
+void swtimer_Service(void) {
+	static swtimer_Timer *expired = 0;	// list head, so callbacks may Stop()
+	uint32_t now = timer_Now();
+
+	while (queued != 0) {
+		uint32_t t = swtimer_NextEvent();
+		if ((int32_t) (t - now) > 0) {
+			break;
+		}
+
+		// At a turn of each wheel the matching slot of the next one out
+		// is due within its span. Queued from just before t, so a timer
+		// due at t lands in the inner slot handled below.
+		base = t - 1;
+		for (uint8_t level = 1; level < WHEEL_LEVELS; level++) {
+			if (swtimer_Index(t, level - 1) != 0) {
+				break;
+			}
+			swtimer_Cascade(level, swtimer_Index(t, level));
+		}
+		base = t;
+
+		swtimer_Timer **slot = &wheel[0][t & WHEEL_MASK];
+		if (*slot == 0) {
+			continue;
+		}
+		expired = *slot;
+		expired->pprev = &expired;
+		*slot = 0;
+
+		while (expired) {
+			swtimer_Timer *e = expired;
+
+			swtimer_Unlink(e);
+			queued--;
+			if (e->period_ms != 0) {
+				e->expires += e->period_ms;
+				if ((int32_t) (e->expires - now) <= 0) {
+					e->expires = now + e->period_ms;	// skip lost periods
+				}
+				swtimer_Queue(e);
+				queued++;
+			}
+			if (e->callback) {
+				e->callback(e->arg);
+			}
+		}
+	}
+	if (queued == 0) {
+		base = now;
+	}
+	swtimer_Arm();
+}
+
+uint16_t swtimer_NextDue(void) {
+	if (queued == 0) {
+		return 0xFFFF;
+	}
+	int32_t wait = (int32_t) (swtimer_NextEvent() - timer_Now());
+	if (wait <= 0) {
+		return 0;
+	}
+	return wait > 0xFFFF ? 0xFFFF : (uint16_t) wait;
+}
@@ -0,0 +1,106 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Multi-size text rendering into the OLED framebuffer.
+// ----------------------------------------------------------------------------
+
+#include "text.h"
+#include "font.h"
+#include "oled_fb.h"
+
+// Each bit of a nibble repeated 2 or 3 times: 4 source rows -> 8 or 12 rows
+#define X2(n)	(((n) & 1) * 0x3 | ((n) & 2) * 0x6 | ((n) & 4) * 0xC \
+		| ((n) & 8) * 0x18)
+#define X3(n)	(((n) & 1) * 0x7 | ((n) & 2) * 0x1C | ((n) & 4) * 0x70 \
+		| ((n) & 8) * 0x1C0)
+#define NIBBLES(X)	{ X(0), X(1), X(2), X(3), X(4), X(5), X(6), X(7), \
+		X(8), X(9), X(10), X(11), X(12), X(13), X(14), X(15) }
+
+static const uint8_t expand2[16] = NIBBLES(X2);
+static const uint16_t expand3[16] = NIBBLES(X3);
+
+typedef struct {
+	uint8_t scale;		// 5x7 scale factor, 0 = numeric font
+	uint8_t spacing;	// blank columns after each scaled glyph
+	uint8_t advance;	// cell width in columns
+	uint8_t pages;		// cell height in pages
+} text_Style;
+
+static const text_Style styles[] = {
+	[TEXT_8X8] = { 1, 3, 8, 1 },
+	[TEXT_12X16] = { 2, 2, 12, 2 },
+	[TEXT_16X16] = { 2, 6, 16, 2 },
+	[TEXT_24X24] = { 3, 9, 24, 3 },
+	[TEXT_16X32] = { 0, 0, FONT_NUM_WIDTH, FONT_NUM_PAGES },
+};
+
+// Scale one 8-row source column to scale * 8 rows
+static inline uint32_t text_Expand(uint8_t bits, uint8_t scale) {
+	switch (scale) {
+	case 2:
+		return expand2[bits & 0x0F] | ((uint32_t) expand2[bits >> 4] << 8);
+	case 3:
+		return expand3[bits & 0x0F] | ((uint32_t) expand3[bits >> 4] << 12);
+	default:
+		return bits;
+	}
+}
+
+// Write one tall column, `pages` bytes stacked from the top page down
+static inline void text_Column(uint8_t page, uint8_t col, uint32_t column,
+		uint8_t pages) {
+	for (uint8_t p = 0; p < pages; p++) {
+		fb_Write(page + p, col, (uint8_t) column);
+		column >>= 8;
+	}
+}
+
+static void text_DrawGlyph(uint8_t page, uint8_t col, unsigned char c,
+		const text_Style *style) {
+	uint8_t x = col;
+
+	if (style->scale == 0) {
+		for (uint8_t k = 0; k < style->advance; k++) {
+			text_Column(page, x++, font_NumColumn(c, k), style->pages);
+		}
+		return;
+	}
+
+	const uint8_t *glyph = font_Glyph(&font_5x7, c);
+	for (uint8_t k = 0; k < font_5x7.width; k++) {
+		uint32_t column = text_Expand(glyph[k], style->scale);
+		for (uint8_t r = 0; r < style->scale; r++) {
+			text_Column(page, x++, column, style->pages);
+		}
+	}
+	for (uint8_t k = 0; k < style->spacing; k++) {
+		text_Column(page, x++, 0, style->pages);
+	}
+}
+
+uint8_t text_Draw(uint8_t page, uint8_t col, const char *s, text_Size size) {
+	const text_Style *style = &styles[size];
+	uint8_t x = col;
+
+	if (page + style->pages > OLED_PAGES) {
+		return col;
+	}
+	for (uint8_t i = 0; s[i] != '\0' && x <= OLED_WIDTH - style->advance; i++) {
+		text_DrawGlyph(page, x, (unsigned char) s[i], style);
+		x += style->advance;
+	}
+	return x;
+}
+
+uint16_t text_Width(const char *s, text_Size size) {
+	uint16_t n = 0;
+
+	while (s[n] != '\0') {
+		n++;
+	}
+	return n * styles[size].advance;
+}
+
+uint8_t text_Pages(text_Size size) {
+	return styles[size].pages;
+}
@@ -0,0 +1,197 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// TIM3 timebase: monotonic ms/us clock, wakeup compare and sleeping delay.
+//
+// See "system/include/cmsis/stm32f051x8.h" for register/bit definitions.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "timer.h"
+#include "irq.h"
+
+// Time at the last TIM3 wrap, kept as ms + us remainder (< 1000) so the
+// millisecond read needs no 64-bit division
+static volatile uint64_t base_ms = 0;
+static volatile uint16_t base_us = 0;
+volatile uint32_t timer_wrap_micros = 0;
+static void (*volatile alarm_fn)(void) = 0;
+
+void timer_Init(void) {
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+	TIM3->PSC = 48 - 1; // 48 MHz / 48 = 1 MHz (1 us count)
+	TIM3->ARR = 0xFFFF;
+	TIM3->EGR = TIM_EGR_UG;
+	TIM3->SR = 0;
+	TIM3->DIER = TIM_DIER_UIE;
+	TIM3->CR1 = TIM_CR1_CEN;
+
+	NVIC_EnableIRQ(TIM3_IRQn);
+}
+
+// One wrap = 65536 us = 65 ms + 536 us
+static void timer_Wrap(void) {
+	uint16_t us = base_us + 536;
+	uint64_t ms = base_ms + 65;
+
+	if (us >= 1000) {
+		us -= 1000;
+		ms++;
+	}
+	base_us = us;
+	base_ms = ms;
+	timer_wrap_micros += 0x10000;
+}
+
+// Consistent snapshot of the base and the counter. A wrap that happened
+// while the caller masks or outranks the TIM3 interrupt is still pending
+// in UIF; the counter is read again since it wrapped after the first read.
+static uint16_t timer_Snapshot(uint64_t *ms, uint16_t *us) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint16_t cnt = (uint16_t) TIM3->CNT;
+	*ms = base_ms;
+	*us = base_us;
+	if ((TIM3->SR & TIM_SR_UIF) != 0) {
+		cnt = (uint16_t) TIM3->CNT;
+		uint16_t r = *us + 536;
+		*ms += 65;
+		if (r >= 1000) {
+			r -= 1000;
+			(*ms)++;
+		}
+		*us = r;
+	}
+
+	__set_PRIMASK(primask);
+	return cnt;
+}
+
+// x / 1000 for x < 70000: (x / 8) / 125 by multiply and shift
+static inline uint32_t timer_DivMilli(uint32_t x) {
+	return ((x >> 3) * 8389) >> 20;
+}
+
+uint64_t timer_Now64(void) {
+	uint64_t ms;
+	uint16_t us;
+	uint16_t cnt = timer_Snapshot(&ms, &us);
+	return ms + timer_DivMilli((uint32_t) us + cnt);
+}
+
+uint32_t timer_Now(void) {
+	return (uint32_t) timer_Now64();
+}
+
+uint64_t timer_Micros64(void) {
+	uint64_t ms;
+	uint16_t us;
+	uint16_t cnt = timer_Snapshot(&ms, &us);
+	return ms * 1000 + us + cnt;
+}
+
+uint32_t timer_Micros(void) {
+	uint64_t ms;
+	uint16_t us;
+	uint16_t cnt = timer_Snapshot(&ms, &us);
+	return (uint32_t) ms * 1000 + us + cnt;
+}
+
+void timer_ArmWakeup(uint32_t ms) {
+	if (ms == 0) {
+		ms = 1;
+	} else if (ms > TIMER_WAKEUP_MAX_MS) {
+		ms = TIMER_WAKEUP_MAX_MS;
+	}
+	TIM3->CCR1 = (uint16_t) (TIM3->CNT + ms * 1000);
+	TIM3->SR = ~TIM_SR_CC1IF;
+	TIM3->DIER |= TIM_DIER_CC1IE;
+}
+
+void timer_DisarmWakeup(void) {
+	TIM3->DIER &= ~TIM_DIER_CC1IE;
+	TIM3->SR = ~TIM_SR_CC1IF;
+}
+
+void timer_SetAlarm(uint32_t ms, void (*fn)(void)) {
+	if (ms == 0) {
+		ms = 1;
+	} else if (ms > TIMER_WAKEUP_MAX_MS) {
+		ms = TIMER_WAKEUP_MAX_MS;
+	}
+	TIM3->DIER &= ~TIM_DIER_CC2IE;
+	alarm_fn = fn;
+	TIM3->CCR2 = (uint16_t) (TIM3->CNT + ms * 1000);
+	TIM3->SR = ~TIM_SR_CC2IF;
+	TIM3->DIER |= TIM_DIER_CC2IE;
+}
+
+void timer_CancelAlarm(void) {
+	TIM3->DIER &= ~TIM_DIER_CC2IE;
+	TIM3->SR = ~TIM_SR_CC2IF;
+	alarm_fn = 0;
+}
+
+void timer_Advance(uint32_t ms) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	base_ms += ms;
+	timer_wrap_micros += ms * 1000;
+	__set_PRIMASK(primask);
+
+	// The counter was frozen, so the compare is now late by ms
+	if ((TIM3->DIER & TIM_DIER_CC2IE) != 0) {
+		TIM3->EGR = TIM_EGR_CC2G;
+	}
+}
+
+void timer_sleep(uint32_t ms) {
+	uint32_t start = timer_Now();
+	uint32_t elapsed;
+
+	// WFI between wakeups; with PRIMASK set a wakeup that lands before the
+	// WFI still ends it, and the interrupt is taken after __enable_irq()
+	while ((elapsed = timer_Now() - start) < ms) {
+		__disable_irq();
+		timer_ArmWakeup(ms - elapsed);
+		if (timer_Now() - start < ms) {
+			__WFI();
+		}
+		__enable_irq();
+	}
+	timer_DisarmWakeup();
+}
+
+void TIM3_IRQHandler(void) {
+	IRQ_ENTER();
+	uint16_t sr = (uint16_t) TIM3->SR;
+
+	if ((sr & TIM_SR_UIF) != 0) {
+		// Counter has run on from 0 since the wrap, in microseconds
+		IRQ_LATENCY(IRQ_ID_TIM3, (uint16_t) TIM3->CNT * 48u);
+		// Base and flag change together, or a preempting reader would
+		// see the wrapped counter without the wrap
+		__disable_irq();
+		timer_Wrap();
+		TIM3->SR = ~TIM_SR_UIF;
+		__enable_irq();
+	}
+	if ((sr & TIM_SR_CC1IF) != 0) {
+		// The compare only has to end a WFI
+		TIM3->DIER &= ~TIM_DIER_CC1IE;
+		TIM3->SR = ~TIM_SR_CC1IF;
+	}
+	if ((sr & TIM_SR_CC2IF) != 0 && (TIM3->DIER & TIM_DIER_CC2IE) != 0) {
+		void (*fn)(void) = alarm_fn;
+
+		TIM3->DIER &= ~TIM_DIER_CC2IE;
+		TIM3->SR = ~TIM_SR_CC2IF;
+		alarm_fn = 0;
+		if (fn) {
+			fn();
+		}
+	}
+
+	IRQ_EXIT(IRQ_ID_TIM3);
+}
@@ -0,0 +1,132 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// USART1 console port (TX = PA9, RX = PA10, AF1), 8N1.
+// ----------------------------------------------------------------------------
+
+#include "cmsis/cmsis_device.h"
+#include "uart.h"
+#include "ring.h"
+#include "irq.h"
+#include "metrics.h"
+
+RING_DEFINE(uart_rx, uint8_t, UART_RX_SIZE);	// ISR -> task
+RING_DEFINE(uart_tx, uint8_t, UART_TX_SIZE);	// task -> ISR
+
+static void (*uart_kick)(void) = 0;
+static volatile uint32_t overruns = 0;
+
+static const metrics_Metric uart_metrics[] = {
+	METRICS_COUNTER_OF("rx_dropped", uart_rx.dropped),
+	METRICS_COUNTER_OF("overruns", overruns),
+};
+METRICS_GROUP(uart_group, "uart", uart_metrics);
+
+void uart_Init(uint32_t baud, void (*kick)(void)) {
+	uart_kick = kick;
+	metrics_Register(&uart_group);
+
+	RCC->AHBENR |= RCC_AHBENR_GPIOAEN;
+	RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+
+	// PA9, PA10: alternate function 1 (USART1_TX, USART1_RX)
+	GPIOA->MODER &= ~(GPIO_MODER_MODER9 | GPIO_MODER_MODER10);
+	GPIOA->MODER |= GPIO_MODER_MODER9_1 | GPIO_MODER_MODER10_1;
+	GPIOA->AFR[1] &= ~((0xFu << ((9 - 8) * 4)) | (0xFu << ((10 - 8) * 4)));
+	GPIOA->AFR[1] |= (0x1u << ((9 - 8) * 4)) | (0x1u << ((10 - 8) * 4));
+	// RX idles high; a pull-up keeps it there with no cable
+	GPIOA->PUPDR &= ~GPIO_PUPDR_PUPDR10;
+	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR10_0;
+
+	// Kernel clock from the HSI, which the USART can request in Stop mode:
+	// a received byte wakes the core instead of being lost (idle.c)
+	RCC->CFGR3 = (RCC->CFGR3 & ~RCC_CFGR3_USART1SW) | RCC_CFGR3_USART1SW_HSI;
+
+	// 16x oversampling: BRR = f_hsi / baud (69 for 115200, 0.6 % fast)
+	USART1->CR1 = 0;
+	USART1->BRR = (HSI_VALUE + baud / 2) / baud;
+	USART1->CR3 = USART_CR3_WUS_0 | USART_CR3_WUS_1;	// wake on RXNE
+	USART1->CR1 = USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE
+			| USART_CR1_UESM;
+	USART1->CR1 |= USART_CR1_UE;
+	EXTI->IMR |= EXTI_IMR_MR25;		// USART1 wakeup line
+
+	NVIC_EnableIRQ(USART1_IRQn);
+}
+
+int uart_Getc(void) {
+	uint8_t c;
+
+	if (ring_Pop(&uart_rx, &c) != 0) {
+		return -1;
+	}
+	return c;
+}
+
+void uart_WriteStart(uart_Writer *w, const void *buf, uint16_t len) {
+	PT_INIT(&w->pt);
+	w->buf = (const uint8_t *) buf;
+	w->left = len;
+}
+
+PT_THREAD(uart_Write(uart_Writer *w)) {
+	uint32_t n;
+
+	PT_BEGIN(&w->pt);
+
+	while (w->left != 0) {
+		PT_WAIT_UNTIL(&w->pt, ring_Free(&uart_tx) != 0);
+		n = ring_PushBulk(&uart_tx, w->buf, w->left);
+		w->buf += n;
+		w->left -= n;
+		// The TXE interrupt runs until the ring is empty
+		USART1->CR1 |= USART_CR1_TXEIE;
+	}
+
+	PT_END(&w->pt);
+}
+
+uint8_t uart_TxBusy(void) {
+	return ring_Count(&uart_tx) != 0 || (USART1->ISR & USART_ISR_TC) == 0;
+}
+
+uart_Stats uart_GetStats(void) {
+	uart_Stats s = { uart_rx.dropped, overruns };
+	return s;
+}
+
+void USART1_IRQHandler(void) {
+	IRQ_ENTER();
+
+	uint32_t isr = USART1->ISR;
+
+	if ((isr & USART_ISR_ORE) != 0) {
+		// Blocks further reception until cleared
+		USART1->ICR = USART_ICR_ORECF;
+		overruns++;
+	}
+	if ((isr & USART_ISR_RXNE) != 0) {
+		uint8_t c = (uint8_t) USART1->RDR;
+
+		// A full ring drops the byte (counted in uart_rx.dropped)
+		ring_Push(&uart_rx, &c);
+		if (uart_kick) {
+			uart_kick();
+		}
+	}
+	if ((isr & USART_ISR_TXE) != 0 && (USART1->CR1 & USART_CR1_TXEIE) != 0) {
+		uint8_t c;
+
+		if (ring_Pop(&uart_tx, &c) == 0) {
+			USART1->TDR = c;
+			// Half empty: let a waiting writer refill before the line idles
+			if (ring_Count(&uart_tx) == UART_TX_SIZE / 2 && uart_kick) {
+				uart_kick();
+			}
+		} else {
+			USART1->CR1 &= ~USART_CR1_TXEIE;
+		}
+	}
+
+	IRQ_EXIT(IRQ_ID_USART1);
+}
@@ -0,0 +1,114 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Meter screen layout.
+// ----------------------------------------------------------------------------
+
+#include <string.h>
+#include "ui.h"
+#include "oled_fb.h"
+#include "text.h"
+#include "fmt.h"
+#include "chart.h"
+#include "display.h"
+#include "meas.h"
+#include "sweep.h"
+
+#define FREQ_CHART_WIDTH		40
+#define FREQ_CHART_DECIMATION	5
+#define RES_CHART_DECIMATION	2
+
+static chart_Bucket freqHistory[FREQ_CHART_WIDTH];
+static chart_Bucket resHistory[OLED_WIDTH];
+static chart_Chart freqChart;
+static chart_Chart resChart;
+
+// Values at the last wake check; a change of more than 1/16 (plus a noise
+// floor) counts as activity for the display power manager
+static uint32_t wakeFreq;
+static uint32_t wakeRes;
+
+#define WAKE_FREQ_FLOOR		2		// Hz
+#define WAKE_RES_FLOOR		20		// Ohms, pot/ADC noise
+
+static uint8_t ui_Changed(uint32_t value, uint32_t *ref, uint32_t floor) {
+	uint32_t delta = value > *ref ? value - *ref : *ref - value;
+
+	if (delta > (*ref >> 4) + floor) {
+		*ref = value;
+		return 1;
+	}
+	return 0;
+}
+
+void ui_Init(void) {
+	chart_Init(&freqChart, freqHistory, FREQ_CHART_WIDTH, 0,
+			OLED_WIDTH - FREQ_CHART_WIDTH, 3, FREQ_CHART_DECIMATION,
+			CHART_SCROLL);
+	chart_Init(&resChart, resHistory, OLED_WIDTH, 6, 0, 2,
+			RES_CHART_DECIMATION, CHART_SWEEP);
+}
+
+void ui_Sample(void) {
+	meas_Values meas;
+
+	meas_Read(&meas);
+	chart_Add(&freqChart, meas.freq);
+	chart_Add(&resChart, meas.res);
+
+	// Both references are updated, so evaluate each before combining
+	uint8_t freqChanged = ui_Changed(meas.freq, &wakeFreq, WAKE_FREQ_FLOOR);
+	uint8_t resChanged = ui_Changed(meas.res, &wakeRes, WAKE_RES_FLOOR);
+	if (freqChanged || resChanged) {
+		display_Wake();
+	}
+
+	// A chart only changes on screen when a whole bucket is added
+	if (freqChart.pending != 0 || resChart.pending != 0) {
+		display_Request();
+	}
+}
+
+void ui_Render(void) {
+	// Snapshot of the published values; EXTI2_3 stays enabled so no
+	// frequency edge is lost while the frame is drawn
+	meas_Values meas;
+	meas_Read(&meas);
+
+	// Buffer size = at most 16 characters per PAGE + terminating '\0'
+	char Buffer[17];
+	char unit[4] = { ' ', 'H', 'z', '\0' };
+	uint8_t x;
+	uint8_t n;
+
+	// Frequency in 16x32 digits on pages 0-3, readable across the bench;
+	// 4 significant digits with an SI prefix keep it at 5 cells
+	fmt_SI(Buffer, meas.freq, 4, 5, &unit[0]);
+	x = text_Draw(0, 0, Buffer, TEXT_16X32);
+	text_Draw(3, x + 8, unit, TEXT_8X8);
+	chart_Draw(&freqChart);
+
+	// Resistance in 12x16 digits on pages 4-5
+	fmt_Unsigned(Buffer, meas.res, 5, ' ');
+	x = text_Draw(4, 0, Buffer, TEXT_12X16);
+	text_Draw(5, x + 4, "Ohms", TEXT_8X8);
+
+	// Sweep progress replaces the Res chart on pages 6-7 while it runs
+	if (sweep_IsRunning()) {
+		strcpy(Buffer, "Sweep: ");
+		n = 7;
+		n += fmt_Unsigned(&Buffer[n], sweep_Count(), 3, ' ');
+		Buffer[n++] = '/';
+		fmt_Unsigned(&Buffer[n], sweep_Points(), 3, ' ');
+		text_Draw(6, 0, Buffer, TEXT_8X8);
+		memset(Buffer, ' ', 16);
+		Buffer[16] = '\0';
+		text_Draw(7, 0, Buffer, TEXT_8X8);
+		chart_Invalidate(&resChart);
+	} else {
+		chart_Draw(&resChart);
+	}
+
+	// Frame pacing (~10 frames/sec) and the flush of the changed spans are
+	// done by display_Service(); this only draws into the framebuffer.
+}
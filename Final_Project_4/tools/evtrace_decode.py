@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+# School: University of Victoria, Canada.
+# Course: ECE 355 "Microprocessor-Based Systems".
+# Decoder for the binary event trace (include/evtrace.h).
+#
+# Usage:
+#   evtrace_decode.py trace.bin
+#
+# trace.bin is a dump of evtrace_log, e.g. from gdb
+#   (gdb) dump binary value trace.bin evtrace_log
+# or a capture of the console "trace" command (the log is found by its
+# magic number; any text around it is skipped). Prints one line per event,
+# oldest first, with the time since the first event and since the previous
+# one.
+#
+# EVENTS must follow evtrace_Id in evtrace.h: ids are only ever appended.
+# ----------------------------------------------------------------------------
+
+import struct
+import sys
+
+MAGIC = 0x31525645  # "EVR1"
+HEADER = struct.Struct("<IIII")  # magic, records, head, paused
+RECORD = struct.Struct("<III")  # time, id | a0 << 8, a1
+
+# id: (name, format); {a0} is 24 bits, {a1} 32 bits
+EVENTS = {
+    1: ("button", "btn pressed"),
+    2: ("overflow", "*** Overflow! (input too slow) *** cnt={a1}"),
+    3: ("too_fast", "Too fast (ticks=0)"),
+    4: ("capture", "period {a1} ticks ({hz:.1f} Hz), {a0} queued"),
+    5: ("capture_drop", "capture ring full, period {a1} ticks lost"),
+    6: ("stop", "woke from Stop after {a0} ms"),
+    7: ("sweep", "sweep {sweep}"),
+}
+
+TIMER_HZ = 48000000  # TIM2 clock, for the capture frequency
+
+
+def find_log(data):
+    at = data.find(struct.pack("<I", MAGIC))
+    if at < 0:
+        raise ValueError("no evtrace_log (magic 0x%08X) in the input" % MAGIC)
+    magic, records, head, paused = HEADER.unpack_from(data, at)
+    if records == 0 or records & (records - 1):
+        raise ValueError("bad record count %u" % records)
+    start = at + HEADER.size
+    if len(data) < start + records * RECORD.size:
+        raise ValueError("log truncated: %u records expected" % records)
+    ring = [RECORD.unpack_from(data, start + i * RECORD.size)
+            for i in range(records)]
+    return records, head, ring
+
+
+def events(records, head, ring):
+    first = head - records if head > records else 0
+    for n in range(first, head):
+        time, id_a0, a1 = ring[n % records]
+        yield n, time, id_a0 & 0xFF, id_a0 >> 8, a1
+
+
+def describe(ev, a0, a1):
+    name, fmt = EVENTS.get(ev, ("id%u" % ev, "a0={a0} a1={a1}"))
+    hz = TIMER_HZ / a1 if a1 else 0.0
+    sweep = ("start, %u points" % a1) if a0 else "end"
+    return name, fmt.format(a0=a0, a1=a1, hz=hz, sweep=sweep)
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: %s trace.bin\n" % argv[0])
+        return 2
+    with open(argv[1], "rb") as f:
+        data = f.read()
+    try:
+        records, head, ring = find_log(data)
+    except ValueError as e:
+        sys.stderr.write("%s: %s\n" % (argv[1], e))
+        return 1
+
+    lost = head - records if head > records else 0
+    print("%u events recorded, %u shown, %u overwritten"
+          % (head, head - lost, lost))
+    t0 = prev = None
+    for n, time, ev, a0, a1 in events(records, head, ring):
+        if t0 is None:
+            t0 = prev = time
+        # Timestamps are the low 32 bits of the microsecond clock
+        since = (time - t0) & 0xFFFFFFFF
+        delta = (time - prev) & 0xFFFFFFFF
+        prev = time
+        name, text = describe(ev, a0, a1)
+        print("%6u %12.3f ms %+10.3f ms  %-12s %s"
+              % (n, since / 1000.0, delta / 1000.0, name, text))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
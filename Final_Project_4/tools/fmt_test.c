@@ -0,0 +1,192 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host exactness test of the divide-free formatter (src/fmt.c).
+//
+// Build and run (from Final_Project_4):
+//   gcc -std=gnu11 -O2 -Wall -Iinclude -o fmt_test tools/fmt_test.c
+//       src/fmt.c && ./fmt_test
+//
+// Every result is compared with snprintf:
+//   fmt_Unsigned  %5u and %07u over 0..2,000,000 and the 32-bit edges
+//   fmt_Signed    %6d and %06d over +/-1,000,000 and the 32-bit edges
+//   fmt_Fixed     0-3 decimals (and 9) over +/-300,000, width 0 and 8
+//   fmt_SI        1-5 significant digits, rounded half up, over
+//                 0..2,000,000, around every power of ten and the 32-bit
+//                 edges (the reference rounds in 64-bit integers and
+//                 prints with snprintf)
+// Exit status 1 on the first mismatch. Speed is not measured here: a host
+// CPU divides in hardware, so only fmt_Bench() in a -DPROF_ENABLE build
+// on the board gives the M0 cycle comparison.
+// ----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "fmt.h"
+
+static uint32_t checked = 0;
+
+static void expect(const char *what, int64_t value, int arg, const char *got,
+		uint8_t len, const char *want) {
+	checked++;
+	if (strcmp(got, want) != 0 || len != strlen(want)) {
+		printf("FAIL %s(%lld, %d): \"%s\" (%u), expected \"%s\"\n", what,
+				(long long) value, arg, got, len, want);
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void test_Unsigned(uint32_t v) {
+	char got[FMT_MAX_LEN + 8], want[32];
+	uint8_t len;
+
+	len = fmt_Unsigned(got, v, 5, ' ');
+	snprintf(want, sizeof(want), "%5u", (unsigned) v);
+	expect("fmt_Unsigned", v, 5, got, len, want);
+	len = fmt_Unsigned(got, v, 7, '0');
+	snprintf(want, sizeof(want), "%07u", (unsigned) v);
+	expect("fmt_Unsigned", v, 7, got, len, want);
+	len = fmt_Unsigned(got, v, 0, ' ');
+	snprintf(want, sizeof(want), "%u", (unsigned) v);
+	expect("fmt_Unsigned", v, 0, got, len, want);
+}
+
+static void test_Signed(int32_t v) {
+	char got[FMT_MAX_LEN + 8], want[32];
+	uint8_t len;
+
+	len = fmt_Signed(got, v, 6, ' ');
+	snprintf(want, sizeof(want), "%6d", (int) v);
+	expect("fmt_Signed", v, 6, got, len, want);
+	len = fmt_Signed(got, v, 6, '0');
+	snprintf(want, sizeof(want), "%06d", (int) v);
+	expect("fmt_Signed", v, -6, got, len, want);
+}
+
+static void test_Fixed(int32_t v, uint8_t decimals, uint8_t width) {
+	char got[FMT_MAX_LEN + 8], want[40], body[32];
+	uint64_t magnitude = v < 0 ? -(int64_t) v : v;
+	uint64_t scale = 1;
+	uint8_t len;
+
+	for (uint8_t i = 0; i < decimals; i++) {
+		scale *= 10;
+	}
+	if (decimals == 0) {
+		snprintf(body, sizeof(body), "%s%llu", v < 0 ? "-" : "",
+				(unsigned long long) magnitude);
+	} else {
+		snprintf(body, sizeof(body), "%s%llu.%0*llu", v < 0 ? "-" : "",
+				(unsigned long long) (magnitude / scale), decimals,
+				(unsigned long long) (magnitude % scale));
+	}
+	snprintf(want, sizeof(want), "%*s", width, body);
+	len = fmt_Fixed(got, v, decimals, width);
+	expect("fmt_Fixed", v, decimals * 100 + width, got, len, want);
+}
+
+static void test_SI(uint32_t v, uint8_t digits) {
+	static const char prefixes[] = " kMG";
+	char got[FMT_MAX_LEN + 8], want[40], all[24];
+	char prefix = '?';
+	uint8_t len;
+
+	if (v < 1000) {
+		snprintf(want, sizeof(want), "%u", (unsigned) v);
+		len = fmt_SI(got, v, digits, 0, &prefix);
+		expect("fmt_SI", v, digits, got, len, want);
+		if (prefix != ' ') {
+			printf("FAIL fmt_SI(%u): prefix '%c'\n", (unsigned) v, prefix);
+			exit(EXIT_FAILURE);
+		}
+		return;
+	}
+
+	// Round to `digits` significant digits (at least the integer ones),
+	// half up
+	int n = snprintf(all, sizeof(all), "%u", (unsigned) v);
+	int keep = digits < n - 3 * ((n - 1) / 3) ? n - 3 * ((n - 1) / 3) : digits;
+	keep = keep > n ? n : keep;
+	uint64_t q = 1;
+	for (int i = 0; i < n - keep; i++) {
+		q *= 10;
+	}
+	uint64_t r = (v + q / 2) / q * q;
+	n = snprintf(all, sizeof(all), "%llu", (unsigned long long) r);
+
+	int group = (n - 1) / 3;
+	int integer = n - 3 * group;
+	if (keep < integer) {
+		keep = integer;
+	}
+	if (keep > integer) {
+		snprintf(want, sizeof(want), "%.*s.%.*s", integer, all,
+				keep - integer, all + integer);
+	} else {
+		snprintf(want, sizeof(want), "%.*s", integer, all);
+	}
+	len = fmt_SI(got, v, digits, 0, &prefix);
+	expect("fmt_SI", v, digits, got, len, want);
+	if (prefix != prefixes[group]) {
+		printf("FAIL fmt_SI(%u, %u): prefix '%c', expected '%c'\n",
+				(unsigned) v, digits, prefix, prefixes[group]);
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(void) {
+	static const uint32_t edges[] = {
+		0, 1, 9, 10, 99, 100, 999, 1000, 9999, 10000, 99999, 100000,
+		999999, 1000000, 9999999, 10000000, 99999999, 100000000,
+		999999999, 1000000000, 2147483647u, 2147483648u, 4294967294u,
+		4294967295u,
+	};
+	static const int32_t signed_edges[] = {
+		INT32_MIN, INT32_MIN + 1, -2147483647 + 100, -1000000000,
+		1000000000, INT32_MAX,
+	};
+	for (uint32_t v = 0; v <= 2000000; v++) {
+		test_Unsigned(v);
+		if (v % 7 == 0) {
+			for (uint8_t d = 1; d <= 5; d++) {
+				test_SI(v, d);
+			}
+		}
+	}
+	for (uint32_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		test_Unsigned(edges[i]);
+		for (int32_t k = -3; k <= 3; k++) {
+			for (uint8_t d = 1; d <= 5; d++) {
+				test_SI(edges[i] + k, d);
+			}
+		}
+	}
+	for (uint32_t p = 1000; p != 0 && p <= 1000000000u; p *= 10) {
+		for (uint32_t v = p - p / 50; v <= p + p / 50; v += 1 + p / 5000) {
+			for (uint8_t d = 1; d <= 5; d++) {
+				test_SI(v, d);
+			}
+		}
+	}
+
+	for (int32_t v = -1000000; v <= 1000000; v++) {
+		test_Signed(v);
+	}
+	for (uint32_t i = 0; i < sizeof(signed_edges) / sizeof(signed_edges[0]);
+			i++) {
+		test_Signed(signed_edges[i]);
+		test_Fixed(signed_edges[i], 3, 0);
+		test_Fixed(signed_edges[i], 9, 0);
+	}
+
+	for (int32_t v = -300000; v <= 300000; v++) {
+		for (uint8_t d = 0; d <= 3; d++) {
+			test_Fixed(v, d, v % 2 ? 8 : 0);
+		}
+	}
+
+	printf("passed: %u comparisons\n", (unsigned) checked);
+	return EXIT_SUCCESS;
+}
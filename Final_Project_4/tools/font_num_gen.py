@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+# School: University of Victoria, Canada.
+# Course: ECE 355 "Microprocessor-Based Systems".
+# Generator for the 16x32 numeric font (src/font_16x32.def).
+#
+# Usage:
+#   font_num_gen.py > src/font_16x32.def
+#
+# The characters are drawn from seven segments and a decimal point. Each
+# segment is a column range and the rows it covers in every one of those
+# columns; horizontal bars overlap the verticals at the corners. The output
+# holds the 16 finished 32-row columns of every character, so the firmware
+# only indexes a table. Change the shapes here, not in the .def file.
+# ----------------------------------------------------------------------------
+
+WIDTH = 16      # FONT_NUM_WIDTH: columns per cell, gap included
+
+
+def rows(first, last):
+    """Rows first..last set in a 32-bit column (bit 0 = top row)."""
+    return ((1 << (last + 1)) - 1) & ~((1 << first) - 1)
+
+
+# segment: (first column, last column, rows)
+OUTLINE = {
+    "a": (1, 11, rows(0, 2)),
+    "b": (10, 12, rows(1, 15)),
+    "c": (10, 12, rows(15, 29)),
+    "d": (1, 11, rows(28, 30)),
+    "e": (0, 2, rows(15, 29)),
+    "f": (0, 2, rows(1, 15)),
+    "g": (1, 11, rows(14, 16)),
+    "dp": (5, 7, rows(27, 30)),
+}
+
+#      --a--
+#     |     |
+#     f     b
+#     |     |
+#      --g--
+#     |     |
+#     e     c
+#     |     |
+#      --d--   dp
+#
+# (name, code, segments); the first glyph is blank and stands in for any
+# character not listed
+GLYPHS = (
+    ("SPACE", "' '", ()),
+    ("MINUS", "'-'", ("g",)),
+    ("POINT", "'.'", ("dp",)),
+    ("0", "'0'", ("a", "b", "c", "d", "e", "f")),
+    ("1", "'1'", ("b", "c")),
+    ("2", "'2'", ("a", "b", "g", "e", "d")),
+    ("3", "'3'", ("a", "b", "g", "c", "d")),
+    ("4", "'4'", ("f", "g", "b", "c")),
+    ("5", "'5'", ("a", "f", "g", "c", "d")),
+    ("6", "'6'", ("a", "f", "g", "e", "c", "d")),
+    ("7", "'7'", ("a", "b", "c")),
+    ("8", "'8'", ("a", "b", "c", "d", "e", "f", "g")),
+    ("9", "'9'", ("a", "b", "c", "d", "f", "g")),
+    ("E", "'E'", ("a", "f", "g", "e", "d")),
+    ("R", "'r'", ("e", "g")),
+)
+
+HEADER = """\
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// 16x32 numeric font (seven-segment style), generated by
+// tools/font_num_gen.py from its segment outlines: edit that script and
+// regenerate instead of editing this file.
+//
+// One NUMGLYPH(name, code, c0, ..., c15) per character: its 16 columns,
+// bit 0 = top row. The first glyph is blank and is drawn for every
+// character not listed here.
+// ----------------------------------------------------------------------------
+"""
+
+
+def columns(segments):
+    cols = []
+    for col in range(WIDTH):
+        column = 0
+        for seg in segments:
+            first, last, mask = OUTLINE[seg]
+            if first <= col <= last:
+                column |= mask
+        cols.append(column)
+    return cols
+
+
+def main():
+    print(HEADER)
+    for name, code, segments in GLYPHS:
+        cols = ["0x%08X" % c for c in columns(segments)]
+        print("NUMGLYPH(%s, %s," % (name, code))
+        for i in range(0, WIDTH, 4):
+            end = ")" if i + 4 >= WIDTH else ","
+            print("\t%s%s" % (", ".join(cols[i:i + 4]), end))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+# School: University of Victoria, Canada.
+# Course: ECE 355 "Microprocessor-Based Systems".
+# Flash / RAM footprint by module from the GNU ld map file, with budgets.
+#
+# Usage:
+#   footprint.py [--budget FILE] [--archives] [--sections PATTERN] MAP
+#
+# MAP is the linker map of the Eclipse build (Debug/Final_Project_4.map,
+# written by -Wl,-Map). Every input section placed in FLASH or RAM is
+# charged to the object it came from:
+#   src/main                 project sources
+#   system/stm32f0xx_hal_spi system/ (HAL, CMSIS, newlib glue, trace)
+#   libg_nano/vfprintf       a library member: newlib-nano, libgcc
+#                            (soft-float and division helpers), libm
+# and counted as text, rodata, data or bss. flash = text + rodata + data
+# (the initial values of .data are stored in flash), ram = data + bss;
+# padding between sections is listed as (fill), words stored by the
+# linker script as (linker). The totals add up to the output sections.
+#
+# --archives folds library members into one line per library.
+# --sections lists the input sections (e.g. .data.Characters) of the
+# modules matching PATTERN instead of the module table.
+#
+# --budget compares the result with a budget file and exits with 1 when
+# anything is over. Each budget line is
+#   PATTERN  FLASH  RAM
+# where PATTERN is a module name or glob (fnmatch) and the limits are
+# bytes ("-" = not checked) for the sum of every matching module.
+# '#' starts a comment.
+# ----------------------------------------------------------------------------
+
+import fnmatch
+import re
+import sys
+
+KINDS = ("text", "rodata", "data", "bss")
+
+REGION = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+OUTPUT = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+INPUT = re.compile(
+    r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*\S))?\s*$")
+WRAPPED = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.*\S)\s*$")
+FILL = re.compile(r"^ \*fill\*\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+# Data the linker script itself stores, e.g. the .inits region tables
+SCRIPT = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+"
+                    r"(?:BYTE|SHORT|LONG|QUAD|SQUAD)\b")
+
+# Output sections that take no space in the image
+SKIP = ("._check_stack",)    # link-time check that the stack still fits
+
+
+def module_of(path, archives):
+    m = re.match(r"^(.*)\((.*)\)$", path)
+    if m:
+        lib = re.split(r"[/\\]", m.group(1))[-1]
+        lib = re.sub(r"\.a$", "", lib)
+        if archives:
+            return lib
+        member = re.sub(r"^lib_a-|\.o$", "", m.group(2))
+        return "%s/%s" % (lib, member)
+    if path == "linker stubs":
+        return "(linker)"
+    parts = re.split(r"[/\\]", re.sub(r"^\./", "", path))
+    name = re.sub(r"\.o$", "", parts[-1])
+    if parts[0] == "system":
+        return "system/" + name
+    return "/".join(parts[:-1] + [name])
+
+
+def parse(lines, archives):
+    """Returns [(module, kind, input section, size)] and the regions."""
+    regions = {}
+    placed = []
+    state = "start"
+    out = None              # current output section: (name, address)
+    pending = None          # input section name waiting for its next line
+
+    for line in lines:
+        line = line.rstrip("\n")
+        if state == "start":
+            if line.startswith("Memory Configuration"):
+                state = "memory"
+            continue
+        if state == "memory":
+            if line.startswith("Linker script and memory map"):
+                state = "map"
+                continue
+            m = REGION.match(line)
+            if m and m.group(1) != "Name":
+                regions[m.group(1)] = (int(m.group(2), 16),
+                                       int(m.group(3), 16))
+            continue
+
+        if line.startswith(".") and not line.startswith(" "):
+            m = OUTPUT.match(line)
+            out = (m.group(1), int(m.group(2), 16) if m.group(2) else None)
+            pending = None
+            continue
+        if out is None:
+            continue
+        if out[1] is None:
+            # Output section name on a line of its own
+            m = re.match(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)", line)
+            if m:
+                out = (out[0], int(m.group(1), 16))
+            continue
+
+        name = addr = size = path = None
+        m = FILL.match(line)
+        if m:
+            name, addr, size, path = ("*fill*", int(m.group(1), 16),
+                                      int(m.group(2), 16), None)
+        elif SCRIPT.match(line):
+            m = SCRIPT.match(line)
+            name, addr, size, path = (line.split()[2], int(m.group(1), 16),
+                                      int(m.group(2), 16), "linker stubs")
+        elif pending is not None:
+            m = WRAPPED.match(line)
+            if m:
+                name, addr, size, path = (pending, int(m.group(1), 16),
+                                          int(m.group(2), 16), m.group(3))
+            pending = None
+        if name is None:
+            m = INPUT.match(line)
+            if not m or m.group(1).startswith("*("):
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)
+                continue
+            name, addr, size, path = (m.group(1), int(m.group(2), 16),
+                                      int(m.group(3), 16), m.group(4))
+        if size == 0 or out[0] in SKIP:
+            continue
+
+        region = region_of(regions, out[1])
+        if region is None:
+            continue
+        if region == "RAM":
+            kind = "data" if out[0].startswith(".data") else "bss"
+        else:
+            kind = "rodata" if name.startswith(".rodata") else "text"
+        module = "(fill)" if path is None else module_of(path, archives)
+        placed.append([addr, size, module, kind, name])
+
+    if state != "map":
+        raise ValueError("not a GNU ld map file (no memory map)")
+
+    # Merged string sections (.rodata.str1.1) are listed at their size
+    # before merging; they end where the next section starts
+    placed.sort(key=lambda p: p[0])
+    for p, after in zip(placed, placed[1:]):
+        if p[0] + p[1] > after[0]:
+            p[1] = after[0] - p[0]
+    return [(m, k, n, size) for _, size, m, k, n in placed if size], regions
+
+
+def region_of(regions, addr):
+    for name in ("FLASH", "RAM"):
+        origin, length = regions.get(name, (0, 0))
+        if origin <= addr < origin + length:
+            return name
+    return None
+
+
+def totals(placed):
+    modules = {}
+    for module, kind, _, size in placed:
+        sizes = modules.setdefault(module, dict.fromkeys(KINDS, 0))
+        sizes[kind] += size
+    for sizes in modules.values():
+        sizes["flash"] = sizes["text"] + sizes["rodata"] + sizes["data"]
+        sizes["ram"] = sizes["data"] + sizes["bss"]
+    return modules
+
+
+def read_budget(path):
+    budget = []
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if not fields:
+                continue
+            if len(fields) != 3:
+                raise ValueError("%s:%u: expected PATTERN FLASH RAM"
+                                 % (path, n))
+            limits = [None if v == "-" else int(v, 0) for v in fields[1:]]
+            budget.append((fields[0], limits[0], limits[1]))
+    return budget
+
+
+def check(modules, budget):
+    """Prints the budget table; returns the number of lines over budget."""
+    over = 0
+    print("%-28s %16s %16s" % ("budget", "flash", "ram"))
+    for pattern, flash_max, ram_max in budget:
+        match = [s for m, s in modules.items() if fnmatch.fnmatch(m, pattern)]
+        flash = sum(s["flash"] for s in match)
+        ram = sum(s["ram"] for s in match)
+        bad = ((flash_max is not None and flash > flash_max)
+               or (ram_max is not None and ram > ram_max))
+        over += bad
+        print("%-28s %16s %16s%s"
+              % (pattern, used(flash, flash_max), used(ram, ram_max),
+                 "  OVER BUDGET" if bad else ""))
+    return over
+
+
+def used(value, limit):
+    return "%u" % value if limit is None else "%u/%u" % (value, limit)
+
+
+def main(argv):
+    args = argv[1:]
+    budget_path = None
+    sections = None
+    archives = False
+    while len(args) > 1 and args[0].startswith("--"):
+        opt = args.pop(0)
+        if opt == "--budget":
+            budget_path = args.pop(0)
+        elif opt == "--sections":
+            sections = args.pop(0)
+        elif opt == "--archives":
+            archives = True
+        else:
+            args = []
+    if len(args) != 1:
+        sys.stderr.write("usage: %s [--budget FILE] [--archives] "
+                         "[--sections PATTERN] MAP\n" % argv[0])
+        return 2
+
+    try:
+        with open(args[0]) as f:
+            placed, regions = parse(f, archives)
+        budget = read_budget(budget_path) if budget_path else []
+    except (OSError, ValueError) as e:
+        sys.stderr.write("%s\n" % e)
+        return 1
+
+    if sections is not None:
+        for module, kind, name, size in sorted(
+                placed, key=lambda p: (p[0], -p[3])):
+            if fnmatch.fnmatch(module, sections):
+                print("%-28s %-7s %6u  %s" % (module, kind, size, name))
+        return 0
+
+    modules = totals(placed)
+    print("%-28s %7s %7s %7s %7s %7s %7s"
+          % (("module",) + KINDS + ("flash", "ram")))
+    rows = sorted(modules.items(), key=lambda i: (-i[1]["flash"], i[0]))
+    for module, s in rows:
+        print("%-28s %7u %7u %7u %7u %7u %7u"
+              % ((module,) + tuple(s[k] for k in KINDS + ("flash", "ram"))))
+    total = dict((k, sum(s[k] for s in modules.values()))
+                 for k in KINDS + ("flash", "ram"))
+    print("%-28s %7u %7u %7u %7u %7u %7u"
+          % (("total",) + tuple(total[k] for k in KINDS + ("flash", "ram"))))
+    for name, key in (("FLASH", "flash"), ("RAM", "ram")):
+        if name in regions and regions[name][1]:
+            size = regions[name][1]
+            print("%-5s %6u of %6u bytes used (%.1f %%)"
+                  % (name, total[key], size, 100.0 * total[key] / size))
+
+    if budget:
+        print("")
+        if check(modules, budget):
+            sys.stderr.write("footprint over budget (%s)\n" % budget_path)
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,27 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host stand-in for the device header, for the host tests in tools/.
+//
+// Only what the modules under test touch: the barrier intrinsics and a
+// TIM3 whose registers the test owns (timer.h reads CNT and SR inline).
+// ----------------------------------------------------------------------------
+
+#ifndef HOST_CMSIS_DEVICE_H_
+#define HOST_CMSIS_DEVICE_H_
+
+#include <stdint.h>
+
+#define __DMB()		__sync_synchronize()
+
+typedef struct {
+	volatile uint32_t CNT;
+	volatile uint32_t SR;
+} host_Tim;
+
+extern host_Tim host_tim3;
+
+#define TIM3		(&host_tim3)
+#define TIM_SR_UIF	(1u << 0)
+
+#endif // HOST_CMSIS_DEVICE_H_
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+# School: University of Victoria, Canada.
+# Course: ECE 355 "Microprocessor-Based Systems".
+# Decoder for the binary metrics frame (include/metrics.h).
+#
+# Usage:
+#   metrics_decode.py frame.bin
+#
+# frame.bin is a capture of the console "metrics bin" command (the frame
+# is found by its sync bytes and version; any text around it is skipped).
+# Checks the frame checksum, then prints one line per metric: name, kind
+# and value (histogram buckets comma separated).
+# ----------------------------------------------------------------------------
+
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+VERSION = 1
+KINDS = ("counter", "gauge", "histogram", "gauge", "record")
+
+
+def parse(data):
+    at = data.find(SYNC + bytes([VERSION]))
+    if at < 0:
+        raise ValueError("no metrics frame (A5 5A 01) in the input")
+    pos = at + 3
+    try:
+        (count,) = struct.unpack_from("<H", data, pos)
+        pos += 2
+        metrics = []
+        for _ in range(count):
+            kind, values, name_len = struct.unpack_from("<BBB", data, pos)
+            pos += 3
+            name = data[pos:pos + name_len].decode("ascii")
+            pos += name_len
+            vals = struct.unpack_from("<%uI" % values, data, pos)
+            pos += 4 * values
+            metrics.append((name, kind, vals))
+        total = sum(data[at + 2:pos + 1])
+    except (struct.error, UnicodeDecodeError):
+        raise ValueError("frame truncated")
+    if pos >= len(data):
+        raise ValueError("frame truncated")
+    if total & 0xFF:
+        raise ValueError("checksum mismatch")
+    return metrics
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: %s frame.bin\n" % argv[0])
+        return 2
+    with open(argv[1], "rb") as f:
+        data = f.read()
+    try:
+        metrics = parse(data)
+    except ValueError as e:
+        sys.stderr.write("%s: %s\n" % (argv[1], e))
+        return 1
+    for name, kind, vals in metrics:
+        kind = KINDS[kind] if kind < len(KINDS) else "kind%u" % kind
+        print("%-24s %-9s %s" % (name, kind, ",".join(map(str, vals))))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,242 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// OLED emulator driver: renders the meter screen on a Linux host.
+//
+// Build (from Final_Project_4, one command):
+//   gcc -std=gnu11 -O2 -Iinclude -Itools/oled_emu -o oled_emu
+//       tools/oled_emu/*.c src/oled_panel.c src/oled_fb.c src/font.c
+//       src/text.c src/fmt.c src/chart.c src/ui.c
+//
+// Usage:
+//   oled_emu [-c sh1106|ssd1306] [-o prefix] [-n frames] [-b bytes] [-W]
+//   oled_emu [-c ...] [-o prefix] -r capture.bin
+//
+// The first form runs oled_config() and then ui_Render() for n frames of
+// synthetic measurements, flushing through the real framebuffer code. It
+// prints the bytes sent per frame and writes prefix_init.pbm,
+// prefix_first.pbm, prefix_sweep.pbm and prefix_last.pbm. It fails (exit 1)
+// if the panel image differs from the framebuffer, if an unchanged frame
+// sends anything, if a frame exceeds the -b budget, or with -W on any
+// controller warning.
+//
+// The second form replays a capture of (D/C#, byte) pairs, e.g. from a
+// logic analyser, and writes prefix.pbm.
+// ----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oled.h"
+#include "oled_fb.h"
+#include "oled_host.h"
+#include "meas.h"
+#include "sweep.h"
+#include "ui.h"
+
+// ~~~ Synthetic measurements in place of meas.c and sweep.c ~~~
+
+static meas_Values host_meas;
+static uint16_t host_sweep_count;
+static uint8_t host_sweep_running;
+
+void meas_Read(meas_Values *out) {
+	*out = host_meas;
+}
+
+uint8_t sweep_IsRunning(void) {
+	return host_sweep_running;
+}
+
+uint16_t sweep_Count(void) {
+	return host_sweep_count;
+}
+
+uint16_t sweep_Points(void) {
+	return 100;
+}
+
+// The power manager in display.c is not part of the emulated build; every
+// emulated frame is rendered anyway
+uint8_t display_Wake(void) {
+	return 0;
+}
+
+void display_Request(void) {
+}
+
+// Frame i: slow frequency drift with a dropout, resistance steps
+static void host_Measure(int i) {
+	host_meas.freq = 1000 + (uint32_t) ((i * 37) % 400);
+	if (i == 25) {
+		host_meas.freq = 0;
+	}
+	if (i >= 50) {
+		host_meas.freq += 12000;	// crosses into kHz
+	}
+	host_meas.res = (uint32_t) (i < 30 ? 2200 : 4700) + (uint32_t) (i & 3);
+	host_sweep_running = (i >= 60 && i < 66);
+	host_sweep_count = host_sweep_running ? (uint16_t) ((i - 60) * 17) : 0;
+}
+
+// ~~~ Checks ~~~
+
+static uint32_t host_Bytes(void) {
+	return host_panel.count.cmd_bytes + host_panel.count.data_bytes;
+}
+
+// Visible panel pixels must match the framebuffer bit for bit
+static int host_Compare(void) {
+	int bad = 0;
+
+	for (uint8_t y = 0; y < EMU_HEIGHT; y++) {
+		for (uint8_t x = 0; x < EMU_WIDTH; x++) {
+			uint8_t want = (fb_Read(y >> 3, x) >> (y & 7)) & 1;
+			if (emu_Pixel(&host_panel, x, y) != want) {
+				bad++;
+			}
+		}
+	}
+	return bad;
+}
+
+static void host_Save(const char *prefix, const char *name) {
+	char path[256];
+
+	snprintf(path, sizeof(path), "%s_%s.pbm", prefix, name);
+	if (emu_WritePBM(&host_panel, path) != 0) {
+		fprintf(stderr, "oled_emu: cannot write %s\n", path);
+	}
+}
+
+static int host_Replay(const char *capture, const char *prefix) {
+	FILE *f = fopen(capture, "rb");
+	int dc;
+	int byte;
+	char path[256];
+
+	if (f == NULL) {
+		perror(capture);
+		return 2;
+	}
+	emu_Reset(&host_panel, host_panel.variant);
+	emu_Select(&host_panel);
+	while ((dc = fgetc(f)) != EOF && (byte = fgetc(f)) != EOF) {
+		if (dc) {
+			emu_Data(&host_panel, (uint8_t) byte);
+		} else {
+			emu_Command(&host_panel, (uint8_t) byte);
+		}
+	}
+	fclose(f);
+
+	snprintf(path, sizeof(path), "%s.pbm", prefix);
+	emu_WritePBM(&host_panel, path);
+	printf("replay: %u command bytes, %u data bytes, %u warnings\n",
+			(unsigned) host_panel.count.cmd_bytes,
+			(unsigned) host_panel.count.data_bytes,
+			(unsigned) host_panel.count.warnings);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	const char *prefix = "oled";
+	const char *capture = NULL;
+	int frames = 80;
+	uint32_t budget = 0;
+	int strict = 0;
+	int failed = 0;
+
+	host_panel.variant = EMU_SH1106;
+	host_panel.log = stderr;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+			i++;
+			host_panel.variant = strcmp(argv[i], "ssd1306") == 0 ?
+					EMU_SSD1306 : EMU_SH1106;
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			prefix = argv[++i];
+		} else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			budget = (uint32_t) strtoul(argv[++i], NULL, 0);
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			capture = argv[++i];
+		} else if (strcmp(argv[i], "-W") == 0) {
+			strict = 1;
+		} else {
+			fprintf(stderr, "usage: %s [-c sh1106|ssd1306] [-o prefix] "
+					"[-n frames] [-b bytes] [-W] [-r capture.bin]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (capture != NULL) {
+		return host_Replay(capture, prefix);
+	}
+
+	oled_config(0);
+	printf("init: %u command bytes, %u data bytes, %u transactions\n",
+			(unsigned) host_panel.count.cmd_bytes,
+			(unsigned) host_panel.count.data_bytes,
+			(unsigned) host_panel.count.frames);
+	host_Save(prefix, "init");
+	if (host_Compare() != 0) {
+		printf("init: panel not blank after oled_config()\n");
+		failed = 1;
+	}
+
+	ui_Init();
+	for (int i = 0; i < frames; i++) {
+		uint32_t before = host_Bytes();
+		uint32_t runs = host_panel.count.frames;
+
+		host_Measure(i);
+		ui_Sample();
+		ui_Render();
+		fb_Flush();
+		host_DmaService();
+
+		uint32_t sent = host_Bytes() - before;
+		int bad = host_Compare();
+		printf("frame %3d: %4u bytes, %2u transactions%s\n", i,
+				(unsigned) sent, (unsigned) (host_panel.count.frames - runs),
+				bad ? "  MISMATCH" : "");
+		if (bad) {
+			failed = 1;
+		}
+		if (budget != 0 && i > 0 && sent > budget) {
+			printf("frame %3d: over the %u byte budget\n", i,
+					(unsigned) budget);
+			failed = 1;
+		}
+
+		// Same values again: nothing may go out on the bus
+		before = host_Bytes();
+		ui_Render();
+		fb_Flush();
+		host_DmaService();
+		if (host_Bytes() != before) {
+			printf("frame %3d: %u bytes for an unchanged frame\n", i,
+					(unsigned) (host_Bytes() - before));
+			failed = 1;
+		}
+
+		if (i == 0) {
+			host_Save(prefix, "first");
+		} else if (i == 62) {
+			host_Save(prefix, "sweep");
+		}
+	}
+	host_Save(prefix, "last");
+
+	printf("total: %u command bytes, %u data bytes, %u warnings\n",
+			(unsigned) host_panel.count.cmd_bytes,
+			(unsigned) host_panel.count.data_bytes,
+			(unsigned) host_panel.count.warnings);
+	if (strict && host_panel.count.warnings != 0) {
+		failed = 1;
+	}
+	return failed;
+}
@@ -0,0 +1,73 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host implementation of the oled.h transport, feeding the emulator.
+//
+// Replaces src/oled.c (SPI2, GPIO and DMA) so the firmware's drawing code
+// and oled_panel.c run unchanged on Linux. A DMA run completes when
+// host_DmaService() is called, i.e. after oled_WriteRun() has returned, as
+// on the target.
+// ----------------------------------------------------------------------------
+
+#include "oled.h"
+#include "oled_host.h"
+
+emu_Panel host_panel;
+
+static oled_DoneCallback done_cb = 0;
+static uint8_t dma_busy = 0;
+
+static void host_Send(uint8_t dc, uint8_t byte) {
+	if (dc == OLED_DATA) {
+		emu_Data(&host_panel, byte);
+	} else {
+		emu_Command(&host_panel, byte);
+	}
+}
+
+// The reset and init complete at once; there is nothing to kick
+void oled_config(void (*kick)(void)) {
+	(void) kick;
+	emu_Reset(&host_panel, host_panel.variant);
+
+	// The frames oled_ResetThread() sends over DMA
+	oled_Run run;
+	for (uint8_t step = 0; oled_InitStep(step, &run); step++) {
+		emu_Select(&host_panel);
+		for (uint16_t i = 0; i < run.len; i++) {
+			host_Send(run.dc, run.buf[run.repeat ? 0 : i]);
+		}
+	}
+}
+
+void oled_Service(void) {
+}
+
+int oled_WriteRun(uint8_t dc, const uint8_t *buf, uint16_t len) {
+	if (dma_busy || len == 0) {
+		return -1;
+	}
+	dma_busy = 1;
+	emu_Select(&host_panel);
+	for (uint16_t i = 0; i < len; i++) {
+		host_Send(dc, buf[i]);
+	}
+	return 0;
+}
+
+uint8_t oled_Busy(void) {
+	return dma_busy;
+}
+
+void oled_SetDoneCallback(oled_DoneCallback cb) {
+	done_cb = cb;
+}
+
+void host_DmaService(void) {
+	while (dma_busy) {
+		dma_busy = 0;
+		if (done_cb) {
+			done_cb();	// may start the next run
+		}
+	}
+}
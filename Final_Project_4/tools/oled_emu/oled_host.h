@@ -0,0 +1,19 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host transport for the OLED emulator.
+// ----------------------------------------------------------------------------
+
+#ifndef OLED_HOST_H_
+#define OLED_HOST_H_
+
+#include "ssd1306_emu.h"
+
+// Panel driven by the oled.h functions; set .variant and .log before
+// oled_config()
+extern emu_Panel host_panel;
+
+// Complete DMA runs (and the runs their callbacks start) until idle
+void host_DmaService(void);
+
+#endif // OLED_HOST_H_
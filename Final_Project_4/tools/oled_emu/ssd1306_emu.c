@@ -0,0 +1,292 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host model of the SSD1306 / SH1106 OLED controller.
+// ----------------------------------------------------------------------------
+
+#include <string.h>
+#include "ssd1306_emu.h"
+
+#define EMU_MAX_LOGGED	20
+
+static void emu_Warn(emu_Panel *emu, const char *what, uint8_t byte) {
+	emu->count.warnings++;
+	if (emu->log && emu->count.warnings == EMU_MAX_LOGGED + 1) {
+		fprintf(emu->log, "oled_emu: further warnings not shown\n");
+	}
+	if (emu->log && emu->count.warnings <= EMU_MAX_LOGGED) {
+		fprintf(emu->log, "oled_emu: %s (0x%02X) after %u command bytes\n",
+				what, byte, (unsigned) emu->count.cmd_bytes);
+	}
+}
+
+void emu_Reset(emu_Panel *emu, emu_Variant variant) {
+	FILE *log = emu->log;
+
+	memset(emu, 0, sizeof(*emu));
+	emu->log = log;
+	emu->variant = variant;
+	emu->cols = variant == EMU_SH1106 ? EMU_RAM_COLS : EMU_WIDTH;
+	emu->mode = 2;
+	emu->col_end = emu->cols - 1;
+	emu->page_end = EMU_PAGES - 1;
+	emu->mux = EMU_HEIGHT - 1;
+	emu->contrast = 0x80;
+
+	// GDDRAM content is undefined after reset; make that visible
+	for (int p = 0; p < EMU_PAGES; p++) {
+		for (int c = 0; c < EMU_RAM_COLS; c++) {
+			emu->ram[p][c] = (uint8_t) (0x55 << (c & 1));
+		}
+	}
+}
+
+void emu_Select(emu_Panel *emu) {
+	emu->count.frames++;
+}
+
+// Parameter bytes that follow each multi-byte command
+static uint8_t emu_ParamCount(const emu_Panel *emu, uint8_t cmd) {
+	switch (cmd) {
+	case 0x81:	// contrast
+	case 0xA8:	// multiplex ratio
+	case 0xD3:	// display offset
+	case 0xD5:	// clock divide / oscillator
+	case 0xD9:	// pre-charge period
+	case 0xDA:	// COM pins
+	case 0xDB:	// VCOMH deselect level
+		return 1;
+	}
+	if (emu->variant == EMU_SH1106) {
+		return cmd == 0xAD ? 1 : 0;	// DC-DC control
+	}
+	switch (cmd) {
+	case 0x20:	// memory addressing mode
+	case 0x8D:	// charge pump
+		return 1;
+	case 0x21:	// column window
+	case 0x22:	// page window
+	case 0xA3:	// vertical scroll area
+		return 2;
+	case 0x29:
+	case 0x2A:	// vertical + horizontal scroll setup
+		return 5;
+	case 0x26:
+	case 0x27:	// horizontal scroll setup
+		return 6;
+	}
+	return 0;
+}
+
+// Commands that only exist on the SSD1306
+static uint8_t emu_Ssd1306Only(uint8_t cmd) {
+	return (cmd >= 0x20 && cmd <= 0x2F) || cmd == 0x8D || cmd == 0xA3;
+}
+
+static void emu_Execute(emu_Panel *emu) {
+	uint8_t c = emu->cmd[0];
+	uint8_t a = emu->cmd[1];
+
+	if (emu->variant == EMU_SH1106) {
+		if (emu_Ssd1306Only(c)) {
+			emu_Warn(emu, "SSD1306 command ignored by the SH1106", c);
+			return;
+		}
+		if (c >= 0x30 && c <= 0x33) {
+			return;		// charge pump voltage
+		}
+	}
+
+	if (c <= 0x0F) {
+		emu->col = (emu->col & 0xF0) | c;
+		if (emu->mode != 2) {
+			emu_Warn(emu, "page-mode column command outside page mode", c);
+		}
+	} else if (c <= 0x1F && (emu->variant == EMU_SH1106 || c <= 0x17)) {
+		emu->col = (uint8_t) ((emu->col & 0x0F) | ((c & 0x0F) << 4));
+		if (emu->mode != 2) {
+			emu_Warn(emu, "page-mode column command outside page mode", c);
+		}
+	} else if (c >= 0x40 && c <= 0x7F) {
+		emu->start_line = c & 0x3F;
+	} else if (c >= 0xB0 && c <= 0xB7) {
+		emu->page = c & 0x07;
+		if (emu->mode != 2) {
+			emu_Warn(emu, "page-mode page command outside page mode", c);
+		}
+	} else {
+		switch (c) {
+		case 0x20:
+			emu->mode = a & 0x03;
+			if (emu->mode == 3) {
+				emu_Warn(emu, "invalid addressing mode", a);
+				emu->mode = 2;
+			}
+			break;
+		case 0x21:
+			emu->col_start = a & 0x7F;
+			emu->col_end = emu->cmd[2] & 0x7F;
+			emu->col = emu->col_start;
+			break;
+		case 0x22:
+			emu->page_start = a & 0x07;
+			emu->page_end = emu->cmd[2] & 0x07;
+			emu->page = emu->page_start;
+			break;
+		case 0x81:
+			emu->contrast = a;
+			break;
+		case 0x8D:
+			emu->charge_pump = a;
+			if ((a & 0x04) == 0) {
+				emu_Warn(emu, "charge pump left disabled", a);
+			}
+			break;
+		case 0xA0:
+		case 0xA1:
+			emu->seg_remap = c & 1;
+			break;
+		case 0xA4:
+		case 0xA5:
+			emu->entire_on = c & 1;
+			break;
+		case 0xA6:
+		case 0xA7:
+			emu->invert = c & 1;
+			break;
+		case 0xA8:
+			emu->mux = a & 0x3F;
+			if (emu->mux < 15) {
+				emu_Warn(emu, "multiplex ratio below 16", a);
+			}
+			break;
+		case 0xAE:
+		case 0xAF:
+			emu->display_on = c & 1;
+			break;
+		case 0xC0:
+		case 0xC8:
+			emu->com_reverse = (c >> 3) & 1;
+			break;
+		case 0xD3:
+			emu->offset = a & 0x3F;
+			break;
+		case 0xAD:		// SH1106 DC-DC; expects 0x8A/0x8B
+			if (emu->variant != EMU_SH1106) {
+				emu_Warn(emu, "command not supported by this controller", c);
+			} else if ((a & 0xFE) != 0x8A) {
+				emu_Warn(emu, "unexpected DC-DC control value", a);
+			}
+			break;
+		case 0xD5:
+		case 0xD9:
+		case 0xDA:
+		case 0xDB:
+		case 0xE3:		// NOP
+		case 0x2E:
+		case 0x2F:
+		case 0x26:
+		case 0x27:
+		case 0x29:
+		case 0x2A:
+		case 0xA3:
+			break;
+		default:
+			emu_Warn(emu, "command not supported by this controller", c);
+			break;
+		}
+	}
+}
+
+void emu_Command(emu_Panel *emu, uint8_t byte) {
+	emu->count.cmd_bytes++;
+
+	if (emu->cmd_need != 0) {
+		emu->cmd[emu->cmd_len++] = byte;
+		if (--emu->cmd_need == 0) {
+			emu_Execute(emu);
+		}
+		return;
+	}
+	emu->cmd[0] = byte;
+	emu->cmd_len = 1;
+	emu->cmd_need = emu_ParamCount(emu, byte);
+	if (emu->cmd_need == 0) {
+		emu_Execute(emu);
+	}
+}
+
+void emu_Data(emu_Panel *emu, uint8_t byte) {
+	emu->count.data_bytes++;
+
+	if (emu->cmd_need != 0) {
+		emu_Warn(emu, "data byte while a command expects parameters", byte);
+	}
+	if (emu->col < emu->cols) {
+		emu->ram[emu->page][emu->col] = byte;
+	}
+
+	switch (emu->mode) {
+	case 0:		// horizontal: across the window, then next page
+		if (emu->col++ >= emu->col_end) {
+			emu->col = emu->col_start;
+			emu->page = emu->page >= emu->page_end ?
+					emu->page_start : emu->page + 1;
+		}
+		break;
+	case 1:		// vertical: down the window, then next column
+		if (emu->page++ >= emu->page_end) {
+			emu->page = emu->page_start;
+			emu->col = emu->col >= emu->col_end ?
+					emu->col_start : emu->col + 1;
+		}
+		break;
+	default:	// page: column pointer only
+		if (emu->col < emu->cols - 1) {
+			emu->col++;
+		} else if (emu->variant == EMU_SSD1306) {
+			emu->col = 0;
+		}
+		break;
+	}
+}
+
+uint8_t emu_Pixel(const emu_Panel *emu, uint8_t x, uint8_t y) {
+	if (!emu->display_on || y > emu->mux) {
+		return 0;
+	}
+	if (emu->entire_on) {
+		return 1;
+	}
+
+	// SEG -> RAM column: the SH1106 glass sits 2 columns into its RAM
+	uint8_t first = (uint8_t) ((emu->cols - EMU_WIDTH) / 2);
+	uint8_t col = emu->seg_remap ?
+			(uint8_t) (emu->cols - 1 - first - x) : (uint8_t) (first + x);
+
+	// COM -> RAM row
+	uint8_t com = emu->com_reverse ? (uint8_t) (emu->mux - y) : y;
+	uint8_t row = (uint8_t) ((com + emu->offset + emu->start_line) & 0x3F);
+
+	uint8_t bit = (emu->ram[row >> 3][col] >> (row & 7)) & 1;
+	return bit ^ emu->invert;
+}
+
+int emu_WritePBM(const emu_Panel *emu, const char *path) {
+	FILE *f = fopen(path, "wb");
+
+	if (f == NULL) {
+		return -1;
+	}
+	fprintf(f, "P4\n%d %d\n", EMU_WIDTH, EMU_HEIGHT);
+	for (uint8_t y = 0; y < EMU_HEIGHT; y++) {
+		for (uint8_t x = 0; x < EMU_WIDTH; x += 8) {
+			uint8_t packed = 0;
+			for (uint8_t k = 0; k < 8; k++) {
+				packed |= (uint8_t) (emu_Pixel(emu, x + k, y) << (7 - k));
+			}
+			fputc(packed, f);
+		}
+	}
+	return fclose(f) == 0 ? 0 : -1;
+}
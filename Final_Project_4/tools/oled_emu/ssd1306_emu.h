@@ -0,0 +1,82 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host model of the SSD1306 / SH1106 OLED controller.
+//
+// Fed the same command (D/C# = 0) and data (D/C# = 1) bytes the firmware
+// clocks out on SPI2. Decodes page/column addressing, the SSD1306 memory
+// modes and the display-mapping commands, keeps GDDRAM, and renders the
+// visible 128x64 image. Anything the real part would ignore or treat
+// specially is counted as a warning instead of silently accepted.
+// ----------------------------------------------------------------------------
+
+#ifndef SSD1306_EMU_H_
+#define SSD1306_EMU_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define EMU_RAM_COLS	132		// SH1106 RAM width; SSD1306 uses 128
+#define EMU_PAGES		8
+#define EMU_WIDTH		128
+#define EMU_HEIGHT		64
+
+typedef enum {
+	EMU_SH1106 = 0, EMU_SSD1306
+} emu_Variant;
+
+typedef struct {
+	uint32_t cmd_bytes;		// bytes with D/C# = 0
+	uint32_t data_bytes;	// bytes with D/C# = 1
+	uint32_t frames;		// CS# low periods (transactions)
+	uint32_t warnings;
+} emu_Counters;
+
+typedef struct {
+	emu_Variant variant;
+	uint8_t cols;					// 132 (SH1106) or 128 (SSD1306)
+	uint8_t ram[EMU_PAGES][EMU_RAM_COLS];
+
+	// Address pointers and SSD1306 addressing window
+	uint8_t page;
+	uint8_t col;
+	uint8_t mode;					// 0 horizontal, 1 vertical, 2 page
+	uint8_t col_start, col_end;
+	uint8_t page_start, page_end;
+
+	// Display mapping
+	uint8_t start_line;
+	uint8_t offset;
+	uint8_t mux;
+	uint8_t seg_remap;
+	uint8_t com_reverse;
+	uint8_t invert;
+	uint8_t entire_on;
+	uint8_t display_on;
+	uint8_t contrast;
+	uint8_t charge_pump;			// SSD1306 0x8D setting
+
+	// Multi-byte command being collected
+	uint8_t cmd[7];
+	uint8_t cmd_len;
+	uint8_t cmd_need;
+
+	emu_Counters count;
+	FILE *log;						// warnings are printed here if set
+} emu_Panel;
+
+void emu_Reset(emu_Panel *emu, emu_Variant variant);
+
+// One CS# frame begins (for the transaction count)
+void emu_Select(emu_Panel *emu);
+
+void emu_Command(emu_Panel *emu, uint8_t byte);
+void emu_Data(emu_Panel *emu, uint8_t byte);
+
+// Visible pixel (0/1) after remap, scan direction, start line and invert
+uint8_t emu_Pixel(const emu_Panel *emu, uint8_t x, uint8_t y);
+
+// Write the visible image as a binary PBM; returns 0 on success
+int emu_WritePBM(const emu_Panel *emu, const char *path);
+
+#endif // SSD1306_EMU_H_
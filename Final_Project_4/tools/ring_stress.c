@@ -0,0 +1,269 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host stress test of the SPSC ring buffers (src/ring.c).
+//
+// Build and run (from Final_Project_4):
+//   gcc -std=gnu11 -O2 -Wall -pthread -iquote include -iquote tools/host
+//       -o ring_stress tools/ring_stress.c src/ring.c && ./ring_stress [seconds]
+//
+// First the full / empty edges are checked on one thread: push to full and
+// one more (refused and counted as dropped), pop to empty and one more,
+// Reserve and Peek at the wrap point (contiguous part only), bulk calls
+// larger than the free space or the contents. The indices start just
+// below 2^32, so the free-running counters wrap as well as the slots.
+//
+// Then a producer and a consumer thread run for [seconds] (default 2),
+// each picking Push, PushBulk or Reserve/Commit (Pop, PopBulk or
+// Peek/Release) with random sizes and random pauses, so the two sides
+// meet at every fill level. Elements carry a sequence number and its
+// complement; the consumer must see every accepted element once, in
+// order and intact. Exit status 1 on the first failure.
+// ----------------------------------------------------------------------------
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ring.h"
+
+#define RING_COUNT		8		// small, to wrap often
+#define BULK_MAX		11		// more than the capacity
+#define INDEX_START		0xFFFFFFF0u
+
+typedef struct {
+	uint32_t seq;
+	uint32_t check;		// ~seq
+	uint16_t pad;		// odd element size for the two-part copies
+} Item;
+
+static Item storage[RING_COUNT];
+static ring_Ring ring;
+static volatile int stop = 0;
+static volatile int failed = 0;
+static uint32_t produced, consumed;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL line %d: %s\n", __LINE__, #cond); \
+			exit(EXIT_FAILURE); \
+		} \
+	} while (0)
+
+static void ring_Start(uint32_t index) {
+	CHECK(ring_Init(&ring, storage, sizeof(Item), RING_COUNT) == 0);
+	ring.head = index;
+	ring.tail = index;
+}
+
+static Item item_Make(uint32_t seq) {
+	Item it = { seq, ~seq, (uint16_t) seq };
+	return it;
+}
+
+// ~~~ Single-threaded edge cases ~~~
+
+static void test_Edges(void) {
+	Item it, items[BULK_MAX];
+	uint32_t n;
+	uint32_t seq = 0;
+
+	CHECK(ring_Init(&ring, storage, sizeof(Item), 6) == -1);
+
+	ring_Start(INDEX_START);
+	CHECK(ring_Pop(&ring, &it) == -1);
+	CHECK(ring_PopBulk(&ring, items, BULK_MAX) == 0);
+	n = BULK_MAX;
+	ring_Peek(&ring, &n);
+	CHECK(n == 0);
+
+	// Full, and one more
+	for (int i = 0; i < RING_COUNT; i++) {
+		it = item_Make(seq++);
+		CHECK(ring_Push(&ring, &it) == 0);
+	}
+	CHECK(ring_Count(&ring) == RING_COUNT && ring_Free(&ring) == 0);
+	CHECK(ring_Push(&ring, &it) == -1 && ring.dropped == 1);
+	CHECK(ring_PushBulk(&ring, items, 3) == 0 && ring.dropped == 4);
+	n = 1;
+	ring_Reserve(&ring, &n);
+	CHECK(n == 0);
+
+	// Empty it again, in order
+	for (uint32_t s = 0; s < RING_COUNT; s++) {
+		CHECK(ring_Pop(&ring, &it) == 0 && it.seq == s);
+	}
+	CHECK(ring_Pop(&ring, &it) == -1 && ring_Count(&ring) == 0);
+
+	// Indices now past 2^32; move the slot position to 5 of 8
+	ring_Start(INDEX_START + 5);
+	for (int i = 0; i < BULK_MAX; i++) {
+		items[i] = item_Make(100 + i);
+	}
+	CHECK(ring_PushBulk(&ring, items, BULK_MAX) == RING_COUNT);
+	CHECK(ring.dropped == BULK_MAX - RING_COUNT);
+
+	// Peek sees only the contiguous part up to the end of the buffer
+	n = BULK_MAX;
+	const Item *p = ring_Peek(&ring, &n);
+	CHECK(n == 3 && p[0].seq == 100 && p[2].seq == 102);
+	ring_Release(&ring, n);
+	n = BULK_MAX;
+	p = ring_Peek(&ring, &n);
+	CHECK(n == 5 && p[0].seq == 103);
+	ring_Release(&ring, 2);
+	CHECK(ring_PopBulk(&ring, items, BULK_MAX) == 3 && items[2].seq == 107);
+
+	// Reserve likewise stops at the end of the buffer
+	ring_Start(INDEX_START + 6);
+	n = BULK_MAX;
+	Item *w = ring_Reserve(&ring, &n);
+	CHECK(n == 2);
+	w[0] = item_Make(1);
+	w[1] = item_Make(2);
+	ring_Commit(&ring, 2);
+	n = BULK_MAX;
+	w = ring_Reserve(&ring, &n);
+	CHECK(n == RING_COUNT - 2 && w == &storage[0]);
+	ring_Commit(&ring, 0);
+	CHECK(ring_PopBulk(&ring, items, BULK_MAX) == 2 && items[1].seq == 2);
+}
+
+// ~~~ Two-thread fuzz ~~~
+
+static uint32_t rand_Next(uint32_t *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static void pause_Random(uint32_t *state) {
+	uint32_t r = rand_Next(state) & 15;
+
+	if (r == 0) {
+		sched_yield();
+	} else {
+		for (volatile uint32_t i = 0; i < r * 8; i++) {
+		}
+	}
+}
+
+static void* producer(void *arg) {
+	uint32_t state = 0x1234567u;
+	uint32_t seq = 0;
+	Item items[BULK_MAX];
+	(void) arg;
+
+	while (!stop && !failed) {
+		uint32_t n = 1 + rand_Next(&state) % BULK_MAX;
+		uint32_t done = 0;
+
+		switch (rand_Next(&state) % 3) {
+		case 0:
+			items[0] = item_Make(seq);
+			done = ring_Push(&ring, &items[0]) == 0;
+			break;
+		case 1:
+			for (uint32_t i = 0; i < n; i++) {
+				items[i] = item_Make(seq + i);
+			}
+			done = ring_PushBulk(&ring, items, n);
+			break;
+		default: {
+			Item *w = ring_Reserve(&ring, &n);
+			for (uint32_t i = 0; i < n; i++) {
+				w[i] = item_Make(seq + i);
+			}
+			ring_Commit(&ring, n);
+			done = n;
+			break;
+		}
+		}
+		seq += done;	// refused elements are sent again
+		pause_Random(&state);
+	}
+	produced = seq;
+	return 0;
+}
+
+static int item_Check(const Item *it, uint32_t seq) {
+	if (it->seq != seq || it->check != ~seq || it->pad != (uint16_t) seq) {
+		printf("FAIL: expected %u, got %u/%08x\n", (unsigned) seq,
+				(unsigned) it->seq, (unsigned) it->check);
+		failed = 1;
+		return -1;
+	}
+	return 0;
+}
+
+static void* consumer(void *arg) {
+	uint32_t state = 0x89abcdefu;
+	uint32_t seq = 0;
+	Item items[BULK_MAX];
+	(void) arg;
+
+	// Also drains what is left once the producer has stopped
+	while (!failed && (!stop || ring_Count(&ring) != 0)) {
+		uint32_t n = 1 + rand_Next(&state) % BULK_MAX;
+		uint32_t got = 0;
+
+		switch (rand_Next(&state) % 3) {
+		case 0:
+			if (ring_Pop(&ring, &items[0]) == 0) {
+				got = 1;
+				item_Check(&items[0], seq);
+			}
+			break;
+		case 1:
+			got = ring_PopBulk(&ring, items, n);
+			for (uint32_t i = 0; i < got && !failed; i++) {
+				item_Check(&items[i], seq + i);
+			}
+			break;
+		default: {
+			const Item *p = ring_Peek(&ring, &n);
+			for (uint32_t i = 0; i < n && !failed; i++) {
+				item_Check(&p[i], seq + i);
+			}
+			ring_Release(&ring, n);
+			got = n;
+			break;
+		}
+		}
+		seq += got;
+		pause_Random(&state);
+	}
+	consumed = seq;
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	int seconds = argc > 1 ? atoi(argv[1]) : 2;
+	pthread_t prod, cons;
+
+	test_Edges();
+
+	ring_Start(INDEX_START);
+	pthread_create(&cons, 0, consumer, 0);
+	pthread_create(&prod, 0, producer, 0);
+	struct timespec t = { seconds, 0 };
+	nanosleep(&t, 0);
+	stop = 1;
+	pthread_join(prod, 0);
+	pthread_join(cons, 0);
+
+	if (!failed && consumed != produced) {
+		printf("FAIL: %u produced, %u consumed\n", (unsigned) produced,
+				(unsigned) consumed);
+		failed = 1;
+	}
+	printf("%s: %u elements, %u refused pushes, index wrapped %s\n",
+			failed ? "FAILED" : "passed", (unsigned) consumed,
+			(unsigned) ring.dropped,
+			ring.head < INDEX_START ? "yes" : "no");
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+// ----------------------------------------------------------------------------
+// School: University of Victoria, Canada.
+// Course: ECE 355 "Microprocessor-Based Systems".
+// Host test of the software timer wheel (src/swtimer.c).
+//
+// Build and run (from Final_Project_4):
+//   gcc -std=gnu11 -O2 -Wall -Iinclude -Itools/host -o swtimer_test
+//       tools/swtimer_test.c src/swtimer.c && ./swtimer_test
+//
+// The millisecond clock is simulated. For start times spread over every
+// phase of the first two wheels and delays up to past the second wheel,
+// plus a set of long delays, one timer is started and the clock stepped a
+// millisecond at a time, servicing the wheel whenever the alarm is due.
+// The callback must come exactly at the expiry time (a delay of 0 at the
+// next millisecond). A periodic timer and a timer restarted from its own
+// callback run alongside. Exit status 1 on the first failure.
+// ----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "swtimer.h"
+#include "timer.h"
+
+host_Tim host_tim3;
+
+// ~~~ Simulated timebase in place of timer.c ~~~
+
+static uint32_t now_ms;
+static uint8_t alarm_armed;
+static uint32_t alarm_at;
+static void (*alarm_fn)(void);
+
+uint32_t timer_Now(void) {
+	return now_ms;
+}
+
+void timer_SetAlarm(uint32_t ms, void (*fn)(void)) {
+	if (ms > TIMER_WAKEUP_MAX_MS) {
+		ms = TIMER_WAKEUP_MAX_MS;
+	}
+	alarm_armed = 1;
+	alarm_at = now_ms + ms;
+	alarm_fn = fn;
+}
+
+void timer_CancelAlarm(void) {
+	alarm_armed = 0;
+}
+
+// ~~~ Test ~~~
+
+static uint8_t kicked;
+static uint32_t fired_at;
+static uint32_t fired;
+
+static void test_Kick(void) {
+	kicked = 1;
+}
+
+static void test_Fired(void *arg) {
+	(void) arg;
+	fired_at = now_ms;
+	fired++;
+}
+
+// Advance to `until`, firing the alarm and servicing like the scheduler
+static void test_Run(uint32_t until) {
+	while ((int32_t) (until - now_ms) > 0) {
+		now_ms++;
+		if (alarm_armed && (int32_t) (now_ms - alarm_at) >= 0) {
+			alarm_armed = 0;
+			alarm_fn();
+		}
+		if (kicked) {
+			kicked = 0;
+			swtimer_Service();
+		}
+	}
+}
+
+static int test_OneShot(uint32_t start, uint32_t delay) {
+	static swtimer_Timer t;
+
+	test_Run(start);
+	swtimer_Setup(&t, test_Fired, 0);
+	fired = 0;
+	swtimer_Start(&t, delay, 0);
+	test_Run(start + delay + 1);
+	if (fired != 1 || fired_at != start + (delay != 0 ? delay : 1)
+			|| swtimer_Pending(&t)) {
+		printf("FAIL: start %u delay %u: fired %u times, last at %u\n",
+				(unsigned) start, (unsigned) delay, (unsigned) fired,
+				(unsigned) fired_at);
+		return 1;
+	}
+	return 0;
+}
+
+// Periodic timer plus a one-shot restarted from its callback
+static swtimer_Timer periodic, chained;
+static uint32_t periodic_n, chained_n, chained_due;
+static int chain_fail;
+
+static void test_Periodic(void *arg) {
+	(void) arg;
+	periodic_n++;
+}
+
+static void test_Chained(void *arg) {
+	(void) arg;
+	if (now_ms != chained_due) {
+		chain_fail = 1;
+	}
+	chained_n++;
+	chained_due = now_ms + 1 + chained_n % 300;
+	swtimer_Start(&chained, 1 + chained_n % 300, 0);
+}
+
+int main(void) {
+	static const uint32_t long_delays[] = {
+		4095, 4096, 4097, 8191, 262143, 262144, 262145, 300000,
+		16777215, 16777216, 20000000,
+	};
+	uint32_t pairs = 0;
+	int fail = 0;
+
+	now_ms = 1000;
+	swtimer_Init(test_Kick);
+
+	// Gaps between the runs walk the start time through every phase of
+	// the inner wheels
+	for (uint32_t run = 0; run < 200 && !fail; run++) {
+		for (uint32_t delay = 0; delay <= 4200 && !fail;
+				delay += 1 + delay / 64) {
+			fail = test_OneShot(now_ms + 1 + (pairs * 13) % 64, delay);
+			pairs++;
+		}
+	}
+	for (uint32_t i = 0; i < sizeof(long_delays) / sizeof(long_delays[0])
+			&& !fail; i++) {
+		fail = test_OneShot(now_ms + 37 * i, long_delays[i]);
+		pairs++;
+	}
+
+	// Timers sharing the wheel
+	swtimer_Setup(&periodic, test_Periodic, 0);
+	swtimer_Setup(&chained, test_Chained, 0);
+	swtimer_Start(&periodic, 10, 10);
+	chained_due = now_ms + 1;
+	swtimer_Start(&chained, 1, 0);
+	uint32_t from = now_ms;
+	test_Run(from + 100000);
+	if (periodic_n != 10000 || chain_fail) {
+		printf("FAIL: periodic %u of 10000, chained timer %s\n",
+				(unsigned) periodic_n, chain_fail ? "late" : "on time");
+		fail = 1;
+	}
+
+	printf("%s: %u start/delay pairs, %u chained restarts\n",
+			fail ? "FAILED" : "passed", (unsigned) pairs,
+			(unsigned) chained_n);
+	return fail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -58,8 +58,10 @@ void EXTI0_1_Handler(void);
 
 void tim3_init_1ms_tick(void);
 void timer_sleep(uint16_t ms);
+static uint32_t timer_Now(void);
 //Global Flags
-static volatile uint16_t last_button_time = 0;
+static volatile uint32_t last_button_time = 0;
+static volatile uint16_t tim3_wraps = 0;	// upper half of the ms count
 
 
 
@@ -205,11 +207,11 @@ void EXTI0_1_IRQHandler(void)
     if (EXTI->PR & EXTI_PR_PR0) {
         EXTI->PR = EXTI_PR_PR0;   // write-1-to-clear (assignment is fine)
 
-        //Read current time in ms from TIM3
-        uint16_t now = (uint16_t)TIM3->CNT;
+        //Read current time in ms (32-bit, wraps after 49 days)
+        uint32_t now = timer_Now();
 
         // Time since lass press
-        uint16_t delta =(uint16_t)(now - last_button_time);
+        uint32_t delta = now - last_button_time;
 
         if (delta >= DEBOUNCE_MS){
         	last_button_time = now;
@@ -226,9 +228,33 @@ void tim3_init_1ms_tick(void) {
     TIM3->PSC = 48000 - 1; // 48 MHz / 48000 = 1 kHz (1 ms tick)
     TIM3->ARR = 0xFFFF;
     TIM3->EGR = TIM_EGR_UG;
+    TIM3->SR = 0;
+    TIM3->DIER = TIM_DIER_UIE; // count wraps for the 32-bit ms time
+    NVIC_SetPriority(TIM3_IRQn, 3);
+    NVIC_EnableIRQ(TIM3_IRQn);
     TIM3->CR1 = TIM_CR1_CEN;
 }
 
+void TIM3_IRQHandler(void) {
+    TIM3->SR = ~TIM_SR_UIF;
+    tim3_wraps++;
+}
+
+// 32-bit ms since start-up; also correct in an ISR that outranks TIM3
+// while a wrap is still pending
+static uint32_t timer_Now(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint16_t hi = tim3_wraps;
+    uint16_t lo = (uint16_t) TIM3->CNT;
+    if ((TIM3->SR & TIM_SR_UIF) != 0) {
+        hi++;
+        lo = (uint16_t) TIM3->CNT;
+    }
+    __set_PRIMASK(primask);
+    return ((uint32_t) hi << 16) | lo;
+}
+
 void timer_sleep(uint16_t ms) {
     uint16_t start = (uint16_t) TIM3->CNT;
     while ((uint16_t) ((uint16_t) TIM3->CNT - start) < ms) {